@@ -0,0 +1,648 @@
+#include "bio.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace ck::bio;
+
+// payload sizes in bytes
+#define BIO_BENCH_SIZES ->Arg(4 << 10)->Arg(256 << 10)->Arg(16 << 20)
+
+static buffer_t payload(size_t size) {
+    buffer_t out(size);
+    uint32_t x = 0x9e3779b9;
+    for(auto& b : out) {
+        x = x * 1664525u + 1013904223u;
+        b = (uint8_t)(x >> 24);
+    }
+    return out;
+}
+
+// bytes/sec from the payload size, time/field with fields per iteration
+static void report(benchmark::State& state,size_t bytes,size_t fields = 0) {
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)bytes);
+    if(fields > 0)
+        state.counters["time/field"] = benchmark::Counter((double)fields,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// a temporary file holding the payload, removed at exit
+static const std::string& temp_file(size_t size) {
+    static std::map<size_t,std::string> files;
+    auto& path = files[size];
+    if(path.empty()) {
+        path = "bio_bench_" + std::to_string(size) + ".bin";
+        const auto data = payload(size);
+        std::ofstream(path,std::ios::binary).write((const char*)data.data(),data.size());
+        static struct cleanup {
+            ~cleanup() { for(auto& f : files) std::remove(f.second.c_str()); }
+        } c;
+    }
+    return path;
+}
+
+/////////////////////////////////////////////////////////////////////
+/// baselines
+
+static void BM_memcpy(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        memcpy(out.data(),in.data(),size);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state,size);
+}
+BENCHMARK(BM_memcpy) BIO_BENCH_SIZES;
+
+static void BM_memcpy_u32(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    for(auto _ : state) {
+        uint32_t sum = 0;
+        for(size_t i = 0; i + 4 <= size; i += 4) {
+            uint32_t v;
+            memcpy(&v,in.data() + i,4);
+            sum += v;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_memcpy_u32) BIO_BENCH_SIZES;
+
+static void BM_fread(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        auto f = fopen(path.c_str(),"rb");
+        benchmark::DoNotOptimize(fread(out.data(),1,size,f));
+        fclose(f);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_fread) BIO_BENCH_SIZES;
+
+/////////////////////////////////////////////////////////////////////
+/// readers: small fields and bulk
+
+template<typename R>
+static void read_fields(R& r,size_t size) {
+    uint32_t sum = 0;
+    for(size_t i = 0; i + 4 <= size; i += 4) {
+        uint32_t v = 0;
+        r.read(v);
+        sum += v;
+    }
+    benchmark::DoNotOptimize(sum);
+}
+
+template<typename R>
+static void read_bulk(R& r,buffer_t& out) {
+    benchmark::DoNotOptimize(r.read(out.data(),out.size()));
+}
+
+template<typename I>
+static void BM_buffer_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    for(auto _ : state) {
+        auto r = make_reader<I>(&in);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK_TEMPLATE(BM_buffer_fields,ireader) BIO_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_buffer_fields,direct) BIO_BENCH_SIZES;
+
+// a cursor from one shared source per thread
+static void BM_cursor_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    static source src;
+    if(state.thread_index() == 0)
+        src = source::from_buffer(payload(size));
+    for(auto _ : state) {
+        auto c = src.open();
+        read_fields(c,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_cursor_fields) BIO_BENCH_SIZES;
+BENCHMARK(BM_cursor_fields)->Arg(256 << 10)->Threads(4);
+
+// fixed records of 16 u32 fields, one bounds check per record
+static void BM_buffer_ensure_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    for(auto _ : state) {
+        auto r = make_reader<direct>(&in);
+        uint32_t sum = 0;
+        while(auto c = r.ensure(64)) {
+            for(int i = 0; i < 16; ++i)
+                sum += c.get<uint32_t>();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffer_ensure_fields) BIO_BENCH_SIZES;
+
+static void BM_buffer_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        auto r = make_reader<direct>(&in);
+        read_bulk(r,out);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_buffer_bulk) BIO_BENCH_SIZES;
+
+template<typename I>
+static void BM_stream_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    for(auto _ : state) {
+        si.clear();
+        si.seekg(0);
+        auto r = make_reader<I>(si,size);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK_TEMPLATE(BM_stream_fields,ireader) BIO_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_stream_fields,direct) BIO_BENCH_SIZES;
+
+static void BM_stream_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    buffer_t out(size);
+    for(auto _ : state) {
+        si.clear();
+        si.seekg(0);
+        auto r = make_reader<direct>(si,size);
+        read_bulk(r,out);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_stream_bulk) BIO_BENCH_SIZES;
+
+static void BM_streambuf_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    for(auto _ : state) {
+        si.seekg(0);
+        auto r = make_streambuf_reader<direct>(si,size);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_streambuf_fields) BIO_BENCH_SIZES;
+
+static void BM_buffered_stream_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    for(auto _ : state) {
+        si.clear();
+        si.seekg(0);
+        auto r = make_buffered_reader<direct>(si);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffered_stream_fields) BIO_BENCH_SIZES;
+
+static void BM_forward_stream_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    for(auto _ : state) {
+        si.clear();
+        si.seekg(0);
+        auto r = make_forward_reader<direct>(si,size);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_forward_stream_fields) BIO_BENCH_SIZES;
+
+static void BM_async_stream_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    std::istringstream si(std::string((const char*)in.data(),size));
+    for(auto _ : state) {
+        si.clear();
+        si.seekg(0);
+        auto r = make_async_reader<direct>(si,64 << 10);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_async_stream_fields) BIO_BENCH_SIZES;
+
+static void BM_file_stream_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        std::ifstream fi(path,std::ios::binary);
+        auto r = make_reader<direct>(fi,size);
+        read_bulk(r,out);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_file_stream_bulk) BIO_BENCH_SIZES;
+
+static void BM_file_streambuf_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    for(auto _ : state) {
+        std::ifstream fi(path,std::ios::binary);
+        auto r = make_streambuf_reader<direct>(fi,size);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_file_streambuf_fields) BIO_BENCH_SIZES;
+
+static void BM_file_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    for(auto _ : state) {
+        auto r = make_file_reader<direct>(path,file_sequential,64 << 10);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_file_fields) BIO_BENCH_SIZES;
+
+static void BM_file_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        auto r = make_file_reader<direct>(path,file_sequential);
+        read_bulk(r,out);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_file_bulk) BIO_BENCH_SIZES;
+
+static void BM_mapped_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    for(auto _ : state) {
+        auto r = make_mapped_reader<direct>(path);
+        read_fields(r,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_mapped_fields) BIO_BENCH_SIZES;
+
+static void BM_mapped_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto& path = temp_file(size);
+    buffer_t out(size);
+    for(auto _ : state) {
+        auto r = make_mapped_reader<direct>(path);
+        read_bulk(r,out);
+    }
+    report(state,size);
+}
+BENCHMARK(BM_mapped_bulk) BIO_BENCH_SIZES;
+
+/////////////////////////////////////////////////////////////////////
+/// writers: small fields and bulk
+
+template<typename W>
+static void write_fields(W& w,size_t size) {
+    for(uint32_t i = 0; i + 4 <= size; i += 4)
+        w.write(i);
+}
+
+static void BM_buffer_write_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        write_fields(w,size);
+        w.finish();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffer_write_fields) BIO_BENCH_SIZES;
+
+static void BM_buffer_write_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        w.write(in.data(),size);
+        w.finish();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,size);
+}
+BENCHMARK(BM_buffer_write_bulk) BIO_BENCH_SIZES;
+
+static void BM_stream_write_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        auto w = make_writer<direct>(so);
+        write_fields(w,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_stream_write_fields) BIO_BENCH_SIZES;
+
+static void BM_streambuf_write_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        auto w = make_streambuf_writer<direct>(so);
+        write_fields(w,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_streambuf_write_fields) BIO_BENCH_SIZES;
+
+static void BM_buffered_stream_write_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        auto w = make_buffered_writer<direct>(so);
+        write_fields(w,size);
+        w.flush();
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffered_stream_write_fields) BIO_BENCH_SIZES;
+
+static void BM_async_stream_write_fields(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        auto w = make_async_writer<direct>(so,64 << 10);
+        write_fields(w,size);
+        w.flush();
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_async_stream_write_fields) BIO_BENCH_SIZES;
+
+static void BM_gather_write_bulk(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    for(auto _ : state) {
+        auto w = make_gather_writer<direct>();
+        for(size_t i = 0; i < size; i += 4096)
+            w.write(in.data() + i,size - i < 4096 ? size - i : 4096);
+        benchmark::DoNotOptimize(w.pos());
+    }
+    report(state,size);
+}
+BENCHMARK(BM_gather_write_bulk) BIO_BENCH_SIZES;
+
+/////////////////////////////////////////////////////////////////////
+/// varints, back-patching, filters
+
+static void BM_varint_read(benchmark::State& state) {
+    const auto count = (size_t)state.range(0) / 4;
+    raw_buffer_t in;
+    {
+        auto w = make_writer<direct>(in);
+        uint32_t x = 1;
+        for(size_t i = 0; i < count; ++i,x = x * 1664525u + 1013904223u)
+            w.write_varint(x >> (x & 31));
+    }
+    for(auto _ : state) {
+        fast_reader<Buffer> r(in.data(),in.size());
+        uint32_t sum = 0,v = 0;
+        for(size_t i = 0; i < count; ++i) {
+            r.read_varint(v);
+            sum += v;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state,in.size(),count);
+}
+BENCHMARK(BM_varint_read) BIO_BENCH_SIZES;
+
+static void BM_varint_write(benchmark::State& state) {
+    const auto count = (size_t)state.range(0) / 4;
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        uint32_t x = 1;
+        for(size_t i = 0; i < count; ++i,x = x * 1664525u + 1013904223u)
+            w.write_varint(x >> (x & 31));
+        w.finish();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,out.size(),count);
+}
+BENCHMARK(BM_varint_write) BIO_BENCH_SIZES;
+
+// records of a u32 length header patched through seek once the body is written
+template<typename W>
+static void write_patched(W& w,size_t size) {
+    for(size_t done = 0; done + 4 <= size; done += 256) {
+        const auto at = w.pos();
+        w.write(uint32_t(0));
+        for(uint32_t i = 0; i < 63; ++i)
+            w.write(i);
+        const auto end = w.pos();
+        w.seek((ck::pos_t)at);
+        w.write(uint32_t(end - at));
+        w.seek((ck::pos_t)end);
+    }
+}
+
+static void BM_buffer_back_patch(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        write_patched(w,size);
+        w.finish();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffer_back_patch) BIO_BENCH_SIZES;
+
+static void BM_stream_back_patch(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        auto w = make_writer<direct>(so);
+        write_patched(w,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_stream_back_patch) BIO_BENCH_SIZES;
+
+// the same records, with the header reserved by a placeholder
+template<typename W>
+static void write_placeholder(W& w,size_t size) {
+    for(size_t done = 0; done + 4 <= size; done += 256) {
+        const auto at = w.pos();
+        auto ph = w.template placeholder<uint32_t>();
+        for(uint32_t i = 0; i < 63; ++i)
+            w.write(i);
+        ph.fill(uint32_t(w.pos() - at));
+    }
+}
+
+static void BM_buffer_placeholder(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        write_placeholder(w,size);
+        w.finish();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffer_placeholder) BIO_BENCH_SIZES;
+
+static void BM_buffered_placeholder(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    for(auto _ : state) {
+        std::ostringstream so;
+        writer<BufferedStream,direct> w(so);
+        write_placeholder(w,size);
+    }
+    report(state,size,size / 4);
+}
+BENCHMARK(BM_buffered_placeholder) BIO_BENCH_SIZES;
+
+// 32-byte records encoded on 4 threads, framed in windows of 4096
+static void BM_parallel_write_records(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto count = size / 32;
+    raw_buffer_t out;
+    for(auto _ : state) {
+        out.clear();
+        auto w = make_writer<direct>(out);
+        parallel_write_records(w,count,[](size_t i,fast_writer<Buffer>& rw){
+            rw.write((uint64_t)i);
+            rw.write_varint(i);
+            rw.write((uint32_t)i);
+            for(uint32_t k = 0; k < 4; ++k)
+                rw.write((uint16_t)(i + k));
+        },PrefixVarint,4);
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state,out.size(),count);
+}
+BENCHMARK(BM_parallel_write_records) BIO_BENCH_SIZES;
+
+static void BM_crc32c(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    const auto in = payload(size);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(crc32c(in.data(),size));
+    report(state,size);
+}
+BENCHMARK(BM_crc32c) BIO_BENCH_SIZES;
+
+template<typename C>
+static void BM_decompress(benchmark::State& state) {
+    const auto size = (size_t)state.range(0);
+    buffer_t in;
+    {
+        auto w = make_writer<direct>(in);
+        auto z = make_compressed_writer<C>(w);
+        write_fields(z,size);
+    }
+    buffer_t out(size);
+    for(auto _ : state) {
+        auto r = make_reader<direct>(&in);
+        auto z = make_compressed_reader<C>(r);
+        read_bulk(z,out);
+    }
+    report(state,size);
+}
+BENCHMARK_TEMPLATE(BM_decompress,store_codec) BIO_BENCH_SIZES;
+#ifdef BIO_HAS_LZ4
+BENCHMARK_TEMPLATE(BM_decompress,lz4_codec) BIO_BENCH_SIZES;
+#endif
+#ifdef BIO_HAS_ZSTD
+BENCHMARK_TEMPLATE(BM_decompress,zstd_codec<>) BIO_BENCH_SIZES;
+#endif
+
+// a key lookup in a pack of range(0) blobs of 64 bytes
+static void BM_pack_find(benchmark::State& state) {
+    const auto count = (size_t)state.range(0);
+    const auto blob = payload(64);
+    raw_buffer_t out;
+    {
+        auto w = make_writer<direct>(out);
+        pack_writer<decltype(w)> pk(w);
+        for(size_t i = 0; i < count; ++i)
+            pk.add("asset/" + std::to_string(i),blob.data(),blob.size());
+    }
+    pack_view pk(out.data(),out.size());
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 1024; ++i)
+        keys.push_back("asset/" + std::to_string(i * 7919 % count));
+    size_t i = 0;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(pk.view(keys[i++ & 1023]));
+}
+BENCHMARK(BM_pack_find)->Arg(1 << 10)->Arg(100 << 10);
+
+// range(0) random reads of 512 bytes from a 16 MiB file, one by one or in one batch
+static std::vector<read_request> random_requests(size_t count,buffer_t& out) {
+    out.resize(count * 512);
+    std::vector<read_request> reqs(count);
+    for(size_t i = 0; i < count; ++i) {
+        reqs[i].offset = (i * 2654435761u) % ((16 << 20) - 512);
+        reqs[i].size = 512;
+        reqs[i].data = out.data() + i * 512;
+    }
+    return reqs;
+}
+
+static void BM_pread_random(benchmark::State& state) {
+    raw_file fh(temp_file(16 << 20),file_random);
+    buffer_t out;
+    auto reqs = random_requests((size_t)state.range(0),out);
+    for(auto _ : state)
+        for(auto& r : reqs)
+            benchmark::DoNotOptimize(fh.read_at(r.data,r.size,r.offset));
+    report(state,out.size());
+}
+BENCHMARK(BM_pread_random)->Arg(16)->Arg(256);
+
+static void BM_batch_random(benchmark::State& state) {
+    raw_file fh(temp_file(16 << 20),file_random);
+    buffer_t out;
+    auto reqs = random_requests((size_t)state.range(0),out);
+    batch_reader br(256);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(br.read(fh,reqs));
+    report(state,out.size());
+}
+BENCHMARK(BM_batch_random)->Arg(16)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -1,10 +1,94 @@
 #ifndef CK_BIO_HPP
 #define CK_BIO_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#ifdef _MSC_VER
+#include <cstdlib>
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__BMI2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// crc32c checks SSE4.2 at runtime on x86-64 if the build does not enable it, e.g. without -msse4.2
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__SSE4_2__) && (defined(__GNUC__) || defined(_MSC_VER))
+#define BIO_CRC32C_DISPATCH 1
+#endif
+#if defined(__x86_64__) && (defined(__SSE4_2__) || defined(BIO_CRC32C_DISPATCH))
+#include <nmmintrin.h>
+#endif
+#if defined(BIO_CRC32C_DISPATCH) && defined(__GNUC__)
+#define BIO_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define BIO_TARGET_SSE42
+#endif
+
+// optional codecs, opt-in: define BIO_WITH_LZ4 / BIO_WITH_ZSTD and link -llz4 / -lzstd
+#ifdef BIO_WITH_LZ4
+#include <lz4.h>
+#define BIO_HAS_LZ4 1
+#endif
+#ifdef BIO_WITH_ZSTD
+#include <zstd.h>
+#define BIO_HAS_ZSTD 1
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// io_uring through raw syscalls for batch_reader, no liburing needed
+#if defined(__has_include) && defined(__linux__)
+#if __has_include(<linux/io_uring.h>) && !defined(BIO_NO_URING)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define BIO_HAS_URING 1
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define BIO_NOINLINE __declspec(noinline)
+#else
+#define BIO_NOINLINE __attribute__((noinline))
+#endif
+
 namespace ck
 {
 
@@ -16,11 +100,327 @@ namespace bio
 enum Mode
 {
     Buffer,
-    Stream
+    Stream,
+    BufferedStream, // stream with its own read-ahead / write-behind block
+    Mapped,         // memory mapped file, read only
+    Gather,         // scatter/gather output, large writes are referenced, write only
+    AsyncStream,    // stream with the i/o on a background thread
+    ForwardStream,  // non-seekable stream: pipes, sockets, decompressors; read only
+    Streambuf,      // the streambuf of a stream, without the sentries and state flags of istream/ostream
+    File            // a file descriptor / HANDLE with positional i/o, shareable across threads
 };
 
+// reads/writes so small go through the get/put area of a streambuf byte by byte, which is inline
+constexpr size_t streambuf_small_size = 8;
+
+constexpr size_t default_block_size = 8192;
+
+// the length of a stream is not known
+constexpr size_t unknown_size = (size_t)-1;
+
 using buffer_t = std::vector<uint8_t>;
 
+// allocator that default-initializes instead of value-initializing,
+// so resizing a byte container does not zero-fill the bytes about to be overwritten
+template<typename T,typename A = std::allocator<T>>
+struct default_init_allocator : A {
+    using traits = std::allocator_traits<A>;
+
+    template<typename U>
+    struct rebind {
+        using other = default_init_allocator<U,typename traits::template rebind_alloc<U>>;
+    };
+
+    using A::A;
+    default_init_allocator() = default;
+
+    template<typename U>
+    inline void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new((void*)p) U;
+    }
+    template<typename U,typename... Args>
+    inline void construct(U* p,Args&&... args) {
+        traits::construct((A&)*this,p,std::forward<Args>(args)...);
+    }
+};
+
+// byte buffer without zero-fill on resize
+using raw_buffer_t = std::vector<uint8_t,default_init_allocator<uint8_t>>;
+
+// recycles buffers across messages, so the capacity is only allocated once; not thread safe
+template<typename C = raw_buffer_t>
+struct buffer_pool {
+    // a buffer acquired from the pool, goes back on destruction
+    struct handle {
+        handle(const handle&) = delete;
+        inline handle(handle&& o) : _pool(o._pool),_buf(std::move(o._buf)) {
+            o._pool = nullptr;
+        }
+        inline ~handle() {
+            if(_pool) _pool->release(std::move(_buf));
+        }
+
+        inline C& operator*() { return _buf; }
+        inline C* operator->() { return &_buf; }
+        inline C& get() { return _buf; }
+    private:
+        friend struct buffer_pool;
+        inline handle(buffer_pool* pool,C&& buf) : _pool(pool),_buf(std::move(buf)) {}
+
+        buffer_pool* _pool;
+        C _buf;
+    };
+
+    // max_cached: buffers kept for reuse, the others are freed on release
+    inline explicit buffer_pool(size_t max_cached = 64) : _max(max_cached) {}
+
+    // @return: an empty buffer, with the capacity of a released one if any
+    inline handle acquire() {
+        if(_free.empty())
+            return { this,C() };
+        C buf = std::move(_free.back());
+        _free.pop_back();
+        return { this,std::move(buf) };
+    }
+
+    inline void release(C&& buf) {
+        if(_free.size() >= _max)
+            return;
+        buf.clear();
+        _free.push_back(std::move(buf));
+    }
+private:
+    size_t _max;
+    std::vector<C> _free;
+};
+
+// a non-owning window of bytes, valid as long as the source is alive and unchanged
+struct view_t {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    inline const uint8_t* begin() const { return data; }
+    inline const uint8_t* end() const { return data + size; }
+    inline bool empty() const { return size == 0; }
+};
+
+enum Endian
+{
+    LittleEndian,
+    BigEndian,
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    NativeEndian = BigEndian
+#else
+    NativeEndian = LittleEndian
+#endif
+};
+
+inline uint16_t byteswap(uint16_t v) {
+#ifdef _MSC_VER
+    return _byteswap_ushort(v);
+#else
+    return __builtin_bswap16(v);
+#endif
+}
+
+inline uint32_t byteswap(uint32_t v) {
+#ifdef _MSC_VER
+    return _byteswap_ulong(v);
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+inline uint64_t byteswap(uint64_t v) {
+#ifdef _MSC_VER
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+// reverse the bytes of an arithmetic or enum value
+template<typename T>
+inline T swap_bytes(T v) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,"T must be arithmetic or enum");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,"unsupported size");
+    if constexpr(sizeof(T) == 1) {
+        return v;
+    } else {
+        using U = std::conditional_t<sizeof(T) == 2,uint16_t,
+                  std::conditional_t<sizeof(T) == 4,uint32_t,uint64_t>>;
+        U u;
+        memcpy(&u,&v,sizeof(T));
+        u = byteswap(u);
+        memcpy(&v,&u,sizeof(T));
+        return v;
+    }
+}
+
+// reverse the bytes of each W bytes wide element in place
+template<size_t W>
+inline void swap_bytes_n(uint8_t* p,size_t count) {
+    static_assert(W == 2 || W == 4 || W == 8,"unsupported size");
+    const size_t n = count * W;
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSSE3__)
+    const __m128i mask = W == 2 ? _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14)
+                       : W == 4 ? _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12)
+                                : _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+#if defined(__AVX2__)
+    const __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+    for(; i + 32 <= n; i += 32) {
+        auto v = _mm256_loadu_si256((const __m256i*)(p + i));
+        _mm256_storeu_si256((__m256i*)(p + i),_mm256_shuffle_epi8(v,mask2));
+    }
+#endif
+    for(; i + 16 <= n; i += 16) {
+        auto v = _mm_loadu_si128((const __m128i*)(p + i));
+        _mm_storeu_si128((__m128i*)(p + i),_mm_shuffle_epi8(v,mask));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for(; i + 16 <= n; i += 16) {
+        auto v = _mm_loadu_si128((const __m128i*)(p + i));
+        if constexpr(W == 4) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xB1),0xB1);
+        } else if constexpr(W == 8) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0x1B),0x1B);
+        }
+        v = _mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+        _mm_storeu_si128((__m128i*)(p + i),v);
+    }
+#elif defined(__ARM_NEON)
+    for(; i + 16 <= n; i += 16) {
+        auto v = vld1q_u8(p + i);
+        if constexpr(W == 2) v = vrev16q_u8(v);
+        else if constexpr(W == 4) v = vrev32q_u8(v);
+        else v = vrev64q_u8(v);
+        vst1q_u8(p + i,v);
+    }
+#endif
+    using U = std::conditional_t<W == 2,uint16_t,std::conditional_t<W == 4,uint32_t,uint64_t>>;
+    for(; i < n; i += W) {
+        U u;
+        memcpy(&u,p + i,W);
+        u = byteswap(u);
+        memcpy(p + i,&u,W);
+    }
+}
+
+// reverse the bytes of each element in place
+template<typename T>
+inline void swap_bytes(T* data,size_t count) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,"T must be arithmetic or enum");
+    if constexpr(sizeof(T) > 1)
+        swap_bytes_n<sizeof(T)>((uint8_t*)data,count);
+}
+
+// convert between native and E byte order, the same operation in both directions
+template<Endian E,typename T>
+inline T convert_endian(T v) {
+    if constexpr(E == NativeEndian)
+        return v;
+    else
+        return swap_bytes(v);
+}
+
+// count trailing zero bits, v != 0
+inline unsigned ctz64(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i,v);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctzll(v);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////
+/// varint: unsigned LEB128, signed values are zigzag encoded first
+
+// the max encoded size of T
+template<typename T>
+constexpr size_t varint_max_size = (sizeof(T) * 8 + 6) / 7;
+
+template<typename T>
+inline std::make_unsigned_t<T> zigzag_encode(T v) {
+    using U = std::make_unsigned_t<T>;
+    return ((U)v << 1) ^ (U)(v >> (sizeof(T) * 8 - 1));
+}
+
+template<typename U>
+inline std::make_signed_t<U> zigzag_decode(U v) {
+    return (std::make_signed_t<U>)((v >> 1) ^ (U)(0 - (v & 1)));
+}
+
+// @return: the number of bytes written to out, out must have varint_max_size<T> bytes
+template<typename T>
+inline size_t encode_varint(T v,uint8_t* out) {
+    static_assert(std::is_integral<T>::value && !std::is_same<T,bool>::value,"T must be integral");
+    std::make_unsigned_t<T> u;
+    if constexpr(std::is_signed<T>::value) u = zigzag_encode(v);
+    else u = v;
+    size_t n = 0;
+    while(u >= 0x80) {
+        out[n++] = (uint8_t)(u | 0x80);
+        u >>= 7;
+    }
+    out[n++] = (uint8_t)u;
+    return n;
+}
+
+// @return: the number of bytes consumed, 0 if incomplete, too long or overflow
+template<typename T>
+inline size_t decode_varint(const uint8_t* p,size_t size,T& out) {
+    static_assert(std::is_integral<T>::value && !std::is_same<T,bool>::value,"T must be integral");
+    using U = std::make_unsigned_t<T>;
+    constexpr size_t max_size = varint_max_size<T>;
+    uint64_t v = 0;
+    size_t n = 0;
+    if(size >= 8) {
+        // one 64-bit load: the first byte without the continuation bit ends the value
+        uint64_t w;
+        memcpy(&w,p,8);
+        w = convert_endian<LittleEndian>(w);
+        const uint64_t stop = ~w & 0x8080808080808080ull;
+        if(stop) {
+            n = (ctz64(stop) >> 3) + 1;
+            if(n > max_size)
+                return 0;
+            if(n < 8)
+                w &= (1ull << (n * 8)) - 1;
+#if defined(__BMI2__)
+            v = _pext_u64(w,0x7f7f7f7f7f7f7f7full);
+#else
+            w &= 0x7f7f7f7f7f7f7f7full;
+            w = (w & 0x007f007f007f007full) | ((w & 0x7f007f007f007f00ull) >> 1);
+            w = (w & 0x00003fff00003fffull) | ((w & 0x3fff00003fff0000ull) >> 2);
+            v = (w & 0x000000000fffffffull) | ((w & 0x0fffffff00000000ull) >> 4);
+#endif
+        }
+    }
+    if(n < 1) {
+        // near the end or longer than 8 bytes
+        for(;; ++n) {
+            if(n >= size || n >= max_size)
+                return 0;
+            const auto b = p[n];
+            if(n == 9 && b > 1)
+                return 0;   // out of 64 bits
+            v |= uint64_t(b & 0x7f) << (7 * n);
+            if(!(b & 0x80)) {
+                ++n;
+                break;
+            }
+        }
+    }
+    if(v > (uint64_t)(U)~U(0))
+        return 0;
+    if constexpr(std::is_signed<T>::value) out = zigzag_decode((U)v);
+    else out = (T)v;
+    return n;
+}
+
 /////////////////////////////////////////////////////////////////////
 /// reader
 struct ireader{
@@ -30,12 +430,298 @@ struct ireader{
     virtual size_t offset(pos_t ofs) = 0;
 };
 
-template<Mode MO>
+// empty interface: readers and writers based on it have no vtable,
+// so every call is direct and can be inlined
+struct direct {};
+
+/////////////////////////////////////////////////////////////////////
+/// stats: opt-in i/o counters, enabled by the interface policy with_stats; zero cost otherwise
+
+struct io_stats {
+    const char* label = nullptr;    // set by the user, to tell the objects apart in the hook
+    uint64_t calls = 0;             // read or write calls, including views and peeked bytes consumed
+    uint64_t bytes = 0;             // bytes moved by the calls
+    uint64_t short_calls = 0;       // calls that moved less than asked
+    uint64_t seeks = 0;             // seek and offset calls that reposition
+    uint64_t transfers = 0;         // reads from or writes to the underlying stream
+    uint64_t io_ticks = 0;          // in read/write calls, if timed
+    uint64_t seek_ticks = 0;        // in seek/offset calls, if timed
+};
+
+// receives the counters of an object at its destruction, or at report()
+using stats_hook_t = void(*)(const io_stats&);
+
+inline std::atomic<stats_hook_t>& stats_hook() {
+    static std::atomic<stats_hook_t> hook{ nullptr };
+    return hook;
+}
+
+inline void set_stats_hook(stats_hook_t hook) {
+    stats_hook().store(hook);
+}
+
+// cpu cycles where available, steady clock nanoseconds otherwise
+inline uint64_t stats_ticks() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct stats_base {};
+
+// interface policy with counters, e.g. reader<Buffer,with_stats<>> or writer<Stream,with_stats<iwriter>>;
+// Timed also measures every call with stats_ticks. In-memory modes decode varints, bulk data,
+// schema fields and string views from peek, view or ensure, each counts as a read call of its bytes
+template<typename I = direct,bool Timed = false>
+struct with_stats : I,stats_base {
+    static constexpr bool timed = Timed;
+
+    inline ~with_stats() {
+        report();
+    }
+
+    inline const io_stats& stats() const { return _stats; }
+    inline io_stats& stats() { return _stats; }
+
+    // pass the counters to the hook, if any and if anything was counted
+    inline void report() const {
+        const auto hook = stats_hook().load(std::memory_order_relaxed);
+        if(hook && (_stats.calls > 0 || _stats.seeks > 0))
+            hook(_stats);
+    }
+private:
+    io_stats _stats;
+};
+
+template<typename T>
+using has_stats = std::is_base_of<stats_base,T>;
+
+// an i/o on the underlying stream
+template<typename T>
+inline void count_transfer(T& self) {
+    if constexpr(has_stats<T>::value)
+        ++self.stats().transfers;
+}
+
+// counts the calls of B, whose interface policy is with_stats
+template<typename B>
+struct counted_reader : B {
+    using B::B;
+
+    inline size_t read(uint8_t* buf,size_t size) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto n = B::read(buf,size);
+        auto& s = this->stats();
+        ++s.calls;
+        s.bytes += n;
+        s.short_calls += n < size;
+        if constexpr(B::timed)
+            s.io_ticks += stats_ticks() - t;
+        return n;
+    }
+
+    inline size_t seek(pos_t pos) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto r = B::seek(pos);
+        count_seek(t);
+        return r;
+    }
+
+    inline size_t offset(pos_t ofs) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto r = B::offset(ofs);
+        count_seek(t);
+        return r;
+    }
+
+    // in-memory modes: the bytes taken by view, ensure or consume count as a read of them
+    template<typename R = B>
+    inline auto view(size_t n) -> decltype(std::declval<R&>().view(n)) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto v = B::view(n);
+        count_read(t,n,v.size);
+        return v;
+    }
+
+    template<typename R = B>
+    inline auto ensure(size_t n) -> decltype(std::declval<R&>().ensure(n)) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        auto c = B::ensure(n);
+        count_read(t,n,c ? n : 0);
+        return c;
+    }
+
+    // move past n bytes just peeked
+    inline size_t consume(size_t n) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto r = B::offset((pos_t)n);
+        count_read(t,n,n);
+        return r;
+    }
+private:
+    inline void count_read(uint64_t t,size_t size,size_t n) {
+        auto& s = this->stats();
+        ++s.calls;
+        s.bytes += n;
+        s.short_calls += n < size;
+        if constexpr(B::timed)
+            s.io_ticks += stats_ticks() - t;
+    }
+
+    inline void count_seek(uint64_t t) {
+        auto& s = this->stats();
+        ++s.seeks;
+        if constexpr(B::timed)
+            s.seek_ticks += stats_ticks() - t;
+    }
+};
+
+template<typename B>
+struct counted_writer : B {
+    using B::B;
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto n = B::write(buf,size);
+        auto& s = this->stats();
+        ++s.calls;
+        s.bytes += n;
+        s.short_calls += n < size;
+        if constexpr(B::timed)
+            s.io_ticks += stats_ticks() - t;
+        return n;
+    }
+
+    inline size_t seek(pos_t pos) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto r = B::seek(pos);
+        count_seek(t);
+        return r;
+    }
+
+    inline size_t offset(pos_t ofs) {
+        const auto t = B::timed ? stats_ticks() : 0;
+        const auto r = B::offset(ofs);
+        count_seek(t);
+        return r;
+    }
+private:
+    inline void count_seek(uint64_t t) {
+        auto& s = this->stats();
+        ++s.seeks;
+        if constexpr(B::timed)
+            s.seek_ticks += stats_ticks() - t;
+    }
+};
+
+// B with the counting layer if it has stats, B itself otherwise
+template<typename B>
+using counted_reader_t = std::conditional_t<has_stats<B>::value,counted_reader<B>,B>;
+
+template<typename B>
+using counted_writer_t = std::conditional_t<has_stats<B>::value,counted_writer<B>,B>;
+
+template<Mode MO,typename I = ireader>
 struct basic_reader
 {};
 
-template<>
-struct basic_reader<Buffer> : ireader {
+template<Mode MO,typename I = ireader>
+struct reader;
+
+// unchecked reads over the bytes reserved by ensure(n) of a reader, for fixed layouts:
+// the bounds are checked once by ensure, reading more than n is undefined.
+// The reader is moved past the consumed bytes at commit() or destruction
+struct read_cursor {
+    read_cursor() = default;
+    read_cursor(const read_cursor&) = delete;
+    inline read_cursor(read_cursor&& o) : _p(o._p),_beg(o._beg),_end(o._end),_pos(o._pos) {
+        o._pos = nullptr;
+    }
+    // the n bytes at p, consumed bytes are added to *pos
+    inline read_cursor(const uint8_t* p,size_t n,size_t* pos) : _p(p),_beg(p),_end(p + n),_pos(pos) {}
+    inline ~read_cursor() {
+        commit();
+    }
+
+    // false if ensure failed, nothing can be read then
+    inline explicit operator bool() const {
+        return _pos != nullptr;
+    }
+
+    template<typename T>
+    inline T get() {
+        static_assert(std::is_trivially_copyable<T>::value,"T must be trivially copyable");
+        T v;
+        memcpy(&v,_p,sizeof(T));
+        _p += sizeof(T);
+        return v;
+    }
+
+    // a value stored in E byte order
+    template<Endian E,typename T>
+    inline T get() {
+        return convert_endian<E>(get<T>());
+    }
+
+    template<typename T>
+    inline T get_le() { return get<LittleEndian,T>(); }
+
+    template<typename T>
+    inline T get_be() { return get<BigEndian,T>(); }
+
+    template<typename T>
+    inline read_cursor& read(T& out) {
+        out = get<T>();
+        return *this;
+    }
+
+    template<Endian E,typename T>
+    inline read_cursor& read(T& out) {
+        out = get<E,T>();
+        return *this;
+    }
+
+    inline read_cursor& read(void* out,size_t n) {
+        memcpy(out,_p,n);
+        _p += n;
+        return *this;
+    }
+
+    inline read_cursor& skip(size_t n) {
+        _p += n;
+        return *this;
+    }
+
+    // the next bytes, valid until the reader moves
+    inline const uint8_t* data() const {
+        return _p;
+    }
+
+    // reserved bytes not consumed yet
+    inline size_t remain() const {
+        return (size_t)(_end - _p);
+    }
+
+    inline void commit() {
+        if(!_pos)
+            return;
+        *_pos += (size_t)(_p - _beg);
+        _beg = _p;
+    }
+private:
+    const uint8_t* _p = nullptr;
+    const uint8_t* _beg = nullptr;  // the first byte not committed
+    const uint8_t* _end = nullptr;
+    size_t* _pos = nullptr;         // the position to commit to
+};
+
+template<typename I>
+struct basic_reader<Buffer,I> : I {
     basic_reader(const basic_reader&) = delete;
     inline basic_reader(basic_reader&& o) :
         d(o.d), _cur(o._cur),_is_buffer(o._is_buffer)
@@ -57,26 +743,77 @@ struct basic_reader<Buffer> : ireader {
     }
 
     // @return: the number of bytes have been read, <= size; if equal 0, means eob
-    inline size_t read(uint8_t* buf,size_t size) override {
+    inline size_t read(uint8_t* buf,size_t size) {
         if(!d.p.data || !buf || size < 1)
             return 0;
         const auto remain = end() - _cur;
+        if(remain >= size) {    // keep the size constant for inlined typed reads
+            memcpy(buf,ptr() + _cur,size);
+            _cur += size;
+            return size;
+        }
         if(remain < 1)
             return 0;
+        memcpy(buf,ptr() + _cur,remain);
+        _cur += remain;
+        return remain;
+    }
+
+    // zero-copy read, the bytes are not copied but referenced in the source
+    // @return: view of the next bytes, size <= size; if empty, means eob
+    inline view_t view(size_t size) {
+        const auto v = peek(size);
+        _cur += v.size;
+        return v;
+    }
+
+    // same as view, but the position will not be moved
+    inline view_t peek(size_t size) const {
+        if(!d.p.data || size < 1)
+            return {};
+        const auto remain = end() - _cur;
         if(remain < size)
             size = remain;
-        memcpy(buf,ptr() + _cur,size);
-        _cur += size;
-        return size;
+        return { ptr() + _cur, size };
+    }
+
+    // check once that n bytes remain, to read them without checks
+    // @return: a cursor over them, false if less than n bytes remain
+    inline read_cursor ensure(size_t n) {
+        if(!d.p.data || end() - _cur < n)
+            return {};
+        return { ptr() + _cur,n,&_cur };
+    }
+
+    // the whole source
+    inline view_t source() const {
+        if(!d.p.data)
+            return {};
+        return { ptr(),end() };
     }
 
-    inline size_t pos() const override {
+    // a reader over [offset,offset + length) of the source, clamped to its end,
+    // with its own cursor and bounds; zero-copy, valid as long as the source
+    inline reader<Buffer,I> slice(size_t offset,size_t length) const {
+        const auto src = source();
+        if(offset > src.size) offset = src.size;
+        if(length > src.size - offset) length = src.size - offset;
+        return { src.data + offset,length };
+    }
+
+    // a slice over the next length bytes, the position is moved after it
+    inline reader<Buffer,I> subreader(size_t length) {
+        const auto v = view(length);
+        return { v.data,v.size };
+    }
+
+    inline size_t pos() const {
         return _cur;
     }
 
     // pos < 0: to the end; others: to the pos
     // @return: position after seek
-    inline size_t seek(pos_t pos) override {
+    inline size_t seek(pos_t pos) {
         if(!d.p.data) return 0;
         _cur = end();
         if(pos >= 0 && (size_t)pos < end())
@@ -86,18 +823,19 @@ struct basic_reader<Buffer> : ireader {
 
     // offset from current pos
     // @return: position after offset
-    inline size_t offset(pos_t ofs) override {
+    inline size_t offset(pos_t ofs) {
         if(!d.p.data) return 0;
         auto cur = (pos_t)_cur + ofs;
         if(cur < 0) _cur = 0;
         else if((size_t)cur > end()) _cur = end();
+        else _cur = (size_t)cur;
         return _cur;
     }
 private:
     inline const uint8_t* ptr() const {
         return _is_buffer ? d.p.buf->data() : d.p.data;
     }
-    inline const size_t end() const{
+    inline size_t end() const{
         return _is_buffer ? d.p.buf->size() : d.size;
     }
 
@@ -113,220 +851,4638 @@ private:
     bool _is_buffer = false;
 };
 
-template<>
-struct basic_reader<Stream> : ireader {
+template<typename I>
+struct basic_reader<Stream,I> : I {
     basic_reader(const basic_reader&) = delete;
     inline basic_reader(basic_reader&& o) :
-        _si(o._si),_beg(o._beg),_remain(o._remain)
+        _si(o._si),_beg(o._beg),_end(o._end),_remain(o._remain)
     {}
     inline basic_reader(std::istream& si)
         : _si(si),_beg((size_t)si.tellg())
     {
         si.seekg(0,std::ios::end);
-        _remain = basic_reader<Stream>::pos();
+        _end = (size_t)si.tellg();
+        _remain = _end - _beg;
         si.seekg(_beg,std::ios::beg);
     }
+    // size: the length from the current position, given by the caller so the end is not probed
+    inline basic_reader(std::istream& si,size_t size)
+        : _si(si),_beg((size_t)si.tellg()),_end(_beg + size),_remain(size)
+    {}
+    // a window of size bytes from the absolute stream position beg
+    inline basic_reader(std::istream& si,size_t beg,size_t size)
+        : _si(si),_beg(beg),_end(beg + size),_remain(size)
+    {
+        si.clear();
+        si.seekg(beg,std::ios::beg);
+    }
 
     // fill the "size" as much as possible
-    inline size_t read(uint8_t* buf,size_t size) override {
+    inline size_t read(uint8_t* buf,size_t size) {
         if(_si.eof() || _si.fail() || _remain < 1)
             return 0;
         if(_remain < size)
             size = _remain;
 
         _si.read((char*)buf,size);
+        count_transfer(*this);
         auto sz_read = (size_t)_si.gcount();
         _remain -= sz_read;
         return sz_read;
     }
 
-    inline size_t pos() const override {
+    inline size_t pos() const {
         return (size_t)_si.tellg() - _beg;
     }
 
-    inline size_t seek(pos_t pos) override {
-        _si.seekg(0,std::ios::end);
-        const auto size = _si.tellg();
-        if(pos >= 0)
-        {
-            pos += _beg;
-            if(pos > size)
-                _remain = 0;
-            else {
-                _si.seekg(pos, std::ios::beg);
-                _remain = size_t(size - pos);
-            }
-        }
+    // pos < 0: to the end; others: to the pos
+    inline size_t seek(pos_t pos) {
+        const auto size = _end - _beg;
+        if(pos < 0 || (size_t)pos > size)
+            pos = (pos_t)size;
+        _si.clear();
+        _si.seekg(_beg + pos,std::ios::beg);
+        _remain = size - (size_t)pos;
         return this->pos();
     }
 
-    inline size_t offset(pos_t ofs) override {
-        _si.seekg(ofs,std::ios::cur);
-        return this->pos();
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
+
+    // a reader over [offset,offset + length) of this one, clamped to its end, with its own bounds;
+    // it shares the stream, so seek this reader before reading it again
+    inline reader<Stream,I> slice(size_t offset,size_t length) {
+        const auto size = _end - _beg;
+        if(offset > size) offset = size;
+        if(length > size - offset) length = size - offset;
+        return { _si,_beg + offset,length };
     }
 private:
     std::istream& _si;
     const size_t _beg;  // the position of begin
+    size_t _end;        // the position of end
     size_t _remain;
 };
 
-template<Mode MO>
-struct reader : public basic_reader<MO> {
-    using super = basic_reader<MO>;
-    using super::basic_reader;
+// the position is tracked here, so only a seek calls pubseekoff/pubseekpos of the streambuf;
+// reading it through the istream meanwhile moves the position under this reader
+template<typename I>
+struct basic_reader<Streambuf,I> : I {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(basic_reader&& o) :
+        _sb(o._sb),_beg(o._beg),_end(o._end),_remain(o._remain)
+    {}
+    inline basic_reader(std::streambuf& sb)
+        : _sb(sb),_beg(tell(sb))
+    {
+        const auto end = sb.pubseekoff(0,std::ios::end,std::ios::in);
+        _end = end < 0 ? _beg : (size_t)end;
+        _remain = _end - _beg;
+        sb.pubseekpos(_beg,std::ios::in);
+    }
+    // the streambuf of si, e.g. std::ifstream or std::stringstream
+    inline basic_reader(std::istream& si)
+        : basic_reader(*si.rdbuf())
+    {}
+    // size: the length from the current position, given by the caller so the end is not probed
+    inline basic_reader(std::streambuf& sb,size_t size)
+        : _sb(sb),_beg(tell(sb)),_end(_beg + size),_remain(size)
+    {}
+    inline basic_reader(std::istream& si,size_t size)
+        : basic_reader(*si.rdbuf(),size)
+    {}
+    // a window of size bytes from the absolute stream position beg
+    inline basic_reader(std::streambuf& sb,size_t beg,size_t size)
+        : _sb(sb),_beg(beg),_end(beg + size),_remain(size)
+    {
+        sb.pubseekpos(beg,std::ios::in);
+    }
 
-    template<typename T>
-    inline size_t read(T* out, size_t capacity) {
-        return super::read((uint8_t*)out,capacity);
+    // fill the "size" as much as possible
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1 || _remain < 1)
+            return 0;
+        if(_remain < size)
+            size = _remain;
+        size_t n = 0;
+        if(size <= streambuf_small_size) {
+            for(; n < size; ++n) {
+                const auto c = _sb.sbumpc();
+                if(c == std::streambuf::traits_type::eof())
+                    break;
+                buf[n] = (uint8_t)c;
+            }
+        } else {
+            n = (size_t)_sb.sgetn((char*)buf,(std::streamsize)size);
+            count_transfer(*this);
+        }
+        _remain -= n;
+        return n;
     }
 
-    template<typename T>
-    size_t read(T* out) {
-        return read(out,sizeof(T));
+    inline size_t pos() const {
+        return _end - _beg - _remain;
     }
-};
 
-inline reader<Buffer> make_reader(const uint8_t* in,size_t in_size)
-{ return { in,in_size }; }
+    // pos < 0: to the end; others: to the pos
+    inline size_t seek(pos_t pos) {
+        const auto size = _end - _beg;
+        if(pos < 0 || (size_t)pos > size)
+            pos = (pos_t)size;
+        if(_sb.pubseekpos(_beg + pos,std::ios::in) < 0)
+            return this->pos();
+        _remain = size - (size_t)pos;
+        return this->pos();
+    }
 
-inline reader<Buffer> make_reader(const buffer_t* in)
-{ return { in }; }
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
 
-inline reader<Stream> make_reader(std::istream& si)
-{ return { si }; }
+    // a reader over [offset,offset + length) of this one, clamped to its end, with its own bounds;
+    // it shares the streambuf, so seek this reader before reading it again
+    inline reader<Streambuf,I> slice(size_t offset,size_t length) {
+        const auto size = _end - _beg;
+        if(offset > size) offset = size;
+        if(length > size - offset) length = size - offset;
+        return { _sb,_beg + offset,length };
+    }
+private:
+    static inline size_t tell(std::streambuf& sb) {
+        const auto at = sb.pubseekoff(0,std::ios::cur,std::ios::in);
+        return at < 0 ? 0 : (size_t)at;
+    }
 
-/////////////////////////////////////////////////////////////////////
-/// writer
-struct iwriter{
-    virtual void reserve(size_t capacity) {};
-    virtual size_t write(const uint8_t* buf,size_t size) = 0;
-    virtual size_t pos() const = 0;
-    virtual size_t seek(pos_t pos) = 0;
-    virtual size_t offset(pos_t ofs) = 0;
+    std::streambuf& _sb;
+    const size_t _beg;  // the position of begin
+    size_t _end;        // the position of end
+    size_t _remain;
 };
 
-template<Mode MO>
-struct basic_writer
-{};
-
-template<>
-struct basic_writer<Buffer> : iwriter
-{
-    basic_writer(const basic_writer&) = delete;
-    inline basic_writer(basic_writer&& o) :
-        _buf(o._buf),_cur(o._cur)
+template<typename I>
+struct basic_reader<BufferedStream,I> : I {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(basic_reader&& o) :
+        _si(o._si),_beg(o._beg),_size(o._size),_blk(std::move(o._blk)),
+        _pos(o._pos),_cur(o._cur),_len(o._len)
     {
-        o._cur = 0;
+        o._cur = o._len = 0;
+    }
+    inline basic_reader(std::istream& si,size_t block_size = default_block_size)
+        : _si(si),_beg((size_t)si.tellg()),_blk(block_size > 0 ? block_size : 1)
+    {
+        si.seekg(0,std::ios::end);
+        _size = (size_t)si.tellg() - _beg;
+        si.seekg(_beg,std::ios::beg);
     }
-    inline basic_writer(buffer_t& buf)
-        : _buf(buf),_cur(0)
-    {}
 
-    inline size_t write(const uint8_t* buf,size_t size) override {
+    // small reads are served from the block, large ones bypass it
+    inline size_t read(uint8_t* buf,size_t size) {
         if(!buf || size < 1)
             return 0;
-        auto sub = _cur + size - _buf.size();
-        if(sub > 0) _buf.resize(_cur + size);
-        memcpy(_buf.data() + _cur,buf,size);
-        _cur += size;
-        return size;
+        const auto avail = _len - _cur;
+        if(avail >= size) {
+            memcpy(buf,_blk.data() + _cur,size);
+            _cur += size;
+            return size;
+        }
+
+        memcpy(buf,_blk.data() + _cur,avail);
+        _cur = _len;
+        size_t done = avail;
+        if(size - done >= _blk.size()) {
+            _pos += _len;
+            _cur = _len = 0;
+            const auto n = fetch(buf + done,size - done);
+            _pos += n;
+            return done + n;
+        }
+
+        refill();
+        auto n = _len - _cur;
+        if(n > size - done)
+            n = size - done;
+        memcpy(buf + done,_blk.data() + _cur,n);
+        _cur += n;
+        return done + n;
     }
 
-    inline void reserve(size_t capacity) override {
-        _buf.reserve(capacity);
+    inline size_t pos() const {
+        return _pos + _cur;
     }
 
-    inline size_t pos() const override {
-        return _cur;
+    // check once that n bytes are available, refilling the block if needed, to read them without checks;
+    // the cursor is valid until the next call on the reader
+    // @return: a cursor over them, false if less than n bytes remain or n exceeds the block size
+    inline read_cursor ensure(size_t n) {
+        if(_len - _cur < n) {
+            if(n > _blk.size())
+                return {};
+            const auto rest = _len - _cur;
+            memmove(_blk.data(),_blk.data() + _cur,rest);
+            _pos += _cur;
+            _cur = 0;
+            _len = rest;
+            _len += fetch(_blk.data() + _len,_blk.size() - _len);
+            if(_len < n)
+                return {};
+        }
+        return { _blk.data() + _cur,n,&_cur };
     }
 
-    inline size_t seek(pos_t pos) override {
-        const auto end = _buf.size();   // cannot move out size
-        _cur = end;
-        if(pos >= 0 && pos < end)
-            _cur = (size_t)pos;
-        return this->pos();
+    // pos < 0: to the end; others: to the pos
+    inline size_t seek(pos_t pos) {
+        if(pos < 0 || (size_t)pos > _size)
+            pos = (pos_t)_size;
+        return move_to((size_t)pos);
     }
 
-    inline size_t offset(pos_t ofs) override {
-        auto end = _buf.size();     // cannot move out size
-        auto cur = (pos_t)_cur + ofs;
-        if(cur < 0) _cur = 0;
-        else if(cur > end) _cur = end;
-        return this->pos();
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        else if((size_t)cur > _size) cur = (pos_t)_size;
+        return move_to((size_t)cur);
     }
 private:
-    buffer_t& _buf;
-    size_t _cur;
+    // the stream is only touched if the target is out of the block
+    inline size_t move_to(size_t pos) {
+        if(pos >= _pos && pos <= _pos + _len) {
+            _cur = pos - _pos;
+            return pos;
+        }
+        _si.clear();
+        _si.seekg(_beg + pos,std::ios::beg);
+        _pos = pos;
+        _cur = _len = 0;
+        return pos;
+    }
+
+    inline void refill() {
+        _pos += _len;
+        _cur = _len = 0;
+        auto n = _size - _pos;
+        if(n > _blk.size())
+            n = _blk.size();
+        _len = fetch(_blk.data(),n);
+    }
+
+    inline size_t fetch(uint8_t* buf,size_t size) {
+        if(_si.fail())
+            return 0;
+        if(size > _size - _pos - _len)
+            size = _size - _pos - _len;
+        if(size < 1)
+            return 0;
+        _si.read((char*)buf,size);
+        count_transfer(*this);
+        return (size_t)_si.gcount();
+    }
+
+    std::istream& _si;
+    const size_t _beg;  // the position of begin
+    size_t _size = 0;   // the stream size from begin
+    buffer_t _blk;      // read-ahead block
+    size_t _pos = 0;    // the position of block begin
+    size_t _cur = 0;    // current position in the block
+    size_t _len = 0;    // valid bytes in the block
 };
 
-template<>
-struct basic_writer<Stream> : iwriter
-{
-    basic_writer(const basic_writer&) = delete;
-    inline basic_writer(basic_writer&& o) :
-        _so(o._so),_beg(o._beg)
-    {}
-    inline basic_writer(std::ostream& so)
-        : _so(so),_beg((size_t)so.tellp())
+// never seeks or queries the position of the stream, the position is counted;
+// seek/offset move forward by skipping, backward only inside the current block
+template<typename I>
+struct basic_reader<ForwardStream,I> : I {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(basic_reader&& o) :
+        _si(o._si),_size(o._size),_blk(std::move(o._blk)),_pos(o._pos),_cur(o._cur),_len(o._len)
+    {
+        o._cur = o._len = 0;
+    }
+    // size: the length to read, unknown_size to read until the end of stream
+    inline basic_reader(std::istream& si,size_t size = unknown_size,size_t block_size = default_block_size)
+        : _si(si),_size(size),_blk(block_size > 0 ? block_size : 1)
     {}
 
-    inline size_t write(const uint8_t* buf,size_t size) override {
-        if(!buf || _so.fail() || size < 1)
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
             return 0;
+        const auto avail = _len - _cur;
+        if(avail >= size) {
+            memcpy(buf,_blk.data() + _cur,size);
+            _cur += size;
+            return size;
+        }
 
-        const auto before = _so.tellp();
-        _so.write((char*)buf,size);
-        auto pos = _so.tellp();
-        if(pos == (std::streamsize)-1)
+        memcpy(buf,_blk.data() + _cur,avail);
+        _cur = _len;
+        size_t done = avail;
+        if(size - done >= _blk.size()) {
+            _pos += _len;
+            _cur = _len = 0;
+            const auto n = fetch(buf + done,size - done);
+            _pos += n;
+            return done + n;
+        }
+
+        refill();
+        auto n = _len - _cur;
+        if(n > size - done)
+            n = size - done;
+        memcpy(buf + done,_blk.data() + _cur,n);
+        _cur += n;
+        return done + n;
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    // check once that n bytes are available, refilling the block if needed, to read them without checks;
+    // the cursor is valid until the next call on the reader
+    // @return: a cursor over them, false if less than n bytes remain or n exceeds the block size
+    inline read_cursor ensure(size_t n) {
+        if(_len - _cur < n) {
+            if(n > _blk.size())
+                return {};
+            const auto rest = _len - _cur;
+            memmove(_blk.data(),_blk.data() + _cur,rest);
+            _pos += _cur;
+            _cur = 0;
+            _len = rest;
+            _len += fetch(_blk.data() + _len,_blk.size() - _len);
+            if(_len < n)
+                return {};
+        }
+        return { _blk.data() + _cur,n,&_cur };
+    }
+
+    // pos < 0: to the end
+    inline size_t seek(pos_t pos) {
+        if(pos < 0)
+            return skip(unknown_size);
+        if((size_t)pos >= _pos && (size_t)pos <= _pos + _len) {
+            _cur = (size_t)pos - _pos;
+            return this->pos();
+        }
+        if((size_t)pos < _pos)
+            return this->pos();     // cannot move back
+        return skip((size_t)pos - this->pos());
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
+
+    // the length given at construction, or unknown_size
+    inline size_t size() const {
+        return _size;
+    }
+private:
+    inline size_t skip(size_t n) {
+        const auto avail = _len - _cur;
+        if(n <= avail) {
+            _cur += n;
+            return pos();
+        }
+        n -= avail;
+        _pos += _len;
+        _cur = _len = 0;
+        if(n > _size - _pos)
+            n = _size - _pos;
+        if(n > 0 && !_si.fail()) {
+            constexpr auto max = std::numeric_limits<std::streamsize>::max();
+            _si.ignore(n >= (size_t)max ? max : (std::streamsize)n);   // max: until the end
+            count_transfer(*this);
+            _pos += (size_t)_si.gcount();
+        }
+        return pos();
+    }
+
+    inline void refill() {
+        _pos += _len;
+        _cur = _len = 0;
+        _len = fetch(_blk.data(),_blk.size());
+    }
+
+    inline size_t fetch(uint8_t* buf,size_t size) {
+        if(_si.fail())
             return 0;
-        return size_t(pos - before);
+        if(size > _size - _pos - _len)
+            size = _size - _pos - _len;
+        if(size < 1)
+            return 0;
+        _si.read((char*)buf,size);
+        count_transfer(*this);
+        return (size_t)_si.gcount();
     }
 
-    inline size_t pos() const override {
-        return (size_t)_so.tellp() - _beg;
+    std::istream& _si;
+    size_t _size;       // the length to read
+    buffer_t _blk;      // read-ahead block
+    size_t _pos = 0;    // the position of block begin
+    size_t _cur = 0;    // current position in the block
+    size_t _len = 0;    // valid bytes in the block
+};
+
+// double buffered: a background thread fills the next block while the current one is parsed;
+// the stream must not be used by others until the reader is destroyed
+template<typename I>
+struct basic_reader<AsyncStream,I> : I {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(std::istream& si,size_t block_size = default_block_size)
+        : _si(si),_beg((size_t)si.tellg())
+    {
+        si.seekg(0,std::ios::end);
+        _size = (size_t)si.tellg() - _beg;
+        si.seekg(_beg,std::ios::beg);
+        if(block_size < 1) block_size = 1;
+        _front.resize(block_size);
+        _back.resize(block_size);
+        _worker = std::thread([this]{ run(); });
+        prefetch(0);
+    }
+    inline ~basic_reader() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_all();
+        _worker.join();
     }
 
-    inline size_t seek(pos_t pos) override {
-        _so.seekp(0,std::ios::end);
-        const auto tail = _so.tellp();
-        if(pos >= 0)
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        if(_len - _cur >= size) {
+            memcpy(buf,_front.data() + _cur,size);
+            _cur += size;
+            return size;
+        }
+        size_t done = 0;
+        while(done < size) {
+            if(_cur == _len && !refill())
+                break;
+            auto n = _len - _cur;
+            if(n > size - done)
+                n = size - done;
+            memcpy(buf + done,_front.data() + _cur,n);
+            _cur += n;
+            done += n;
+        }
+        return done;
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    // pos < 0: to the end; others: to the pos
+    inline size_t seek(pos_t pos) {
+        if(pos < 0 || (size_t)pos > _size)
+            pos = (pos_t)_size;
+        return move_to((size_t)pos);
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        else if((size_t)cur > _size) cur = (pos_t)_size;
+        return move_to((size_t)cur);
+    }
+private:
+    // a target out of the current block takes the prefetched one if it covers the target,
+    // otherwise the prefetch is restarted at the next refill
+    inline size_t move_to(size_t pos) {
+        if(pos >= _pos && pos <= _pos + _len) {
+            _cur = pos - _pos;
+        } else {
+            _pos = pos;
+            _cur = _len = 0;
+        }
+        return pos;
+    }
+
+    // swap the prefetched block in and start the next one
+    inline bool refill() {
+        const auto want = _pos + _cur;
+        if(want >= _size)
+            return false;
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock,[this]{ return !_pending; });
+        if(!(want >= _fill_pos && want < _fill_pos + _fill_len)) {
+            // the prefetch missed, e.g. after a seek
+            lock.unlock();
+            prefetch(want);
+            lock.lock();
+            _cv.wait(lock,[this]{ return !_pending; });
+            if(_fill_len < 1)
+                return false;   // the stream failed
+        }
+        _front.swap(_back);
+        count_transfer(*this);
+        _pos = _fill_pos;
+        _len = _fill_len;
+        _cur = want - _pos;
+        if(_pos + _len >= _size) {
+            // the last block: _back now holds a stale one, so it must not match again
+            _fill_len = 0;
+            return true;
+        }
+        lock.unlock();
+        prefetch(_pos + _len);
+        return true;
+    }
+
+    inline void prefetch(size_t pos) {
         {
-            pos += _beg;
-            if(pos < tail)
-                _so.seekp(pos,std::ios::beg);
+            std::lock_guard<std::mutex> lock(_mtx);
+            _fill_pos = pos;
+            _fill_len = 0;
+            _pending = true;
         }
-        return this->pos();
+        _cv.notify_all();
     }
 
-    inline size_t offset(pos_t ofs) override {
-        _so.seekp(ofs,std::ios::cur);
-        return this->pos();
+    inline void run() {
+        size_t at = 0;  // the stream position
+        std::unique_lock<std::mutex> lock(_mtx);
+        for(;;) {
+            _cv.wait(lock,[this]{ return _pending || _stop; });
+            if(_stop)
+                return;
+            const auto pos = _fill_pos;
+            lock.unlock();
+
+            size_t n = 0;
+            if(pos < _size) {
+                if(pos != at) {
+                    _si.clear();
+                    _si.seekg(_beg + pos,std::ios::beg);
+                }
+                n = _size - pos;
+                if(n > _back.size())
+                    n = _back.size();
+                _si.read((char*)_back.data(),n);
+                n = (size_t)_si.gcount();
+                at = pos + n;
+            }
+
+            lock.lock();
+            _fill_len = n;
+            _pending = false;
+            _cv.notify_all();
+        }
+    }
+
+    std::istream& _si;
+    const size_t _beg;      // the position of begin
+    size_t _size = 0;       // the stream size from begin
+    buffer_t _front;        // the block being parsed
+    size_t _pos = 0;        // the position of front begin
+    size_t _cur = 0;        // current position in front
+    size_t _len = 0;        // valid bytes in front
+
+    // shared with the worker, guarded by _mtx
+    buffer_t _back;         // the block being filled, owned by the worker while pending
+    size_t _fill_pos = 0;
+    size_t _fill_len = 0;
+    bool _pending = false;
+    bool _stop = false;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::thread _worker;
+};
+
+// read-only memory mapping of a whole file
+struct mapped_file {
+    mapped_file(const mapped_file&) = delete;
+    inline mapped_file(mapped_file&& o) :
+        _data(o._data),_size(o._size)
+    {
+        o._data = nullptr;
+        o._size = 0;
+    }
+    inline explicit mapped_file(const std::string& path) {
+        open(path);
+    }
+    inline ~mapped_file() {
+        close();
+    }
+
+    // false if the file cannot be opened or is empty
+    inline bool is_open() const {
+        return _data != nullptr;
+    }
+    inline const uint8_t* data() const {
+        return _data;
+    }
+    inline size_t size() const {
+        return _size;
     }
 private:
-    std::ostream& _so;
-    const size_t _beg;  // the position of begin
+    inline void open(const std::string& path) {
+#ifdef _WIN32
+        auto file = CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,
+                                OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER size;
+        if(GetFileSizeEx(file,&size) && size.QuadPart > 0) {
+            auto mapping = CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr);
+            if(mapping) {
+                _data = (const uint8_t*)MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+                if(_data) _size = (size_t)size.QuadPart;
+                CloseHandle(mapping);   // the view keeps the mapping alive
+            }
+        }
+        CloseHandle(file);
+#else
+        const int fd = ::open(path.c_str(),O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+            return;
+        struct stat st;
+        if(fstat(fd,&st) == 0 && st.st_size > 0) {
+            auto p = mmap(nullptr,(size_t)st.st_size,PROT_READ,MAP_SHARED,fd,0);
+            if(p != MAP_FAILED) {
+                _data = (const uint8_t*)p;
+                _size = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);    // the mapping keeps the file alive
+#endif
+    }
+
+    inline void close() {
+        if(!_data)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap((void*)_data,_size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
 };
 
-template<Mode MO>
-struct writer : public basic_writer<MO> {
-    using super = basic_writer<MO>;
-    using super::basic_writer;
+// open flags of raw_file
+enum FileFlags : unsigned
+{
+    file_read       = 0,
+    file_write      = 1,    // create or truncate, write only
+    file_sequential = 2,    // hint: read ahead aggressively, posix_fadvise / FILE_FLAG_SEQUENTIAL_SCAN
+    file_random     = 4,    // hint: no read ahead
+    file_direct     = 8     // bypass the page cache, O_DIRECT / FILE_FLAG_NO_BUFFERING; reading only
+};
 
-    template<typename T>
-    inline size_t write(const T* const data, size_t size) {
-        return super::write((uint8_t*)data,size);
+// the alignment of offsets, sizes and buffers for file_direct
+constexpr size_t direct_align = 4096;
+
+#ifdef _WIN32
+using native_file_t = HANDLE;
+#else
+using native_file_t = int;
+#endif
+
+// a file descriptor / HANDLE read and written at explicit offsets,
+// so it is used by several readers on several threads without a shared position
+struct raw_file {
+    raw_file(const raw_file&) = delete;
+    inline raw_file(raw_file&& o) :
+        _h(o._h),_direct(o._direct),_own(o._own)
+    {
+        o._h = invalid();
+    }
+    raw_file() = default;
+    inline explicit raw_file(const std::string& path,unsigned flags = file_read) {
+        open(path,flags);
+    }
+    // h is not owned, it stays open after this
+    inline explicit raw_file(native_file_t h,bool direct = false)
+        : _h(h),_direct(direct),_own(false)
+    {}
+    inline ~raw_file() {
+        close();
+    }
+
+    inline bool is_open() const {
+        return _h != invalid();
+    }
+    inline native_file_t native() const {
+        return _h;
+    }
+    // true if opened with file_direct and the file system supports it
+    inline bool direct() const {
+        return _direct;
+    }
+
+    inline size_t size() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        return is_open() && GetFileSizeEx(_h,&size) ? (size_t)size.QuadPart : 0;
+#else
+        struct stat st;
+        return is_open() && fstat(_h,&st) == 0 ? (size_t)st.st_size : 0;
+#endif
+    }
+
+    // read up to size bytes at the offset, short at the end of file or on an error
+    inline size_t read_at(void* buf,size_t size,size_t offset) const {
+        size_t done = 0;
+        while(done < size) {
+#ifdef _WIN32
+            OVERLAPPED ov{};
+            ov.Offset = (DWORD)(offset + done);
+            ov.OffsetHigh = (DWORD)((uint64_t)(offset + done) >> 32);
+            const auto chunk = size - done < 0x40000000 ? (DWORD)(size - done) : (DWORD)0x40000000;
+            DWORD n = 0;
+            if(!ReadFile(_h,(uint8_t*)buf + done,chunk,&n,&ov) || n == 0)
+                break;
+#else
+            const auto n = ::pread(_h,(uint8_t*)buf + done,size - done,(off_t)(offset + done));
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                break;
+#endif
+            done += (size_t)n;
+        }
+        return done;
+    }
+
+    // write size bytes at the offset, short on an error
+    inline size_t write_at(const void* buf,size_t size,size_t offset) const {
+        size_t done = 0;
+        while(done < size) {
+#ifdef _WIN32
+            OVERLAPPED ov{};
+            ov.Offset = (DWORD)(offset + done);
+            ov.OffsetHigh = (DWORD)((uint64_t)(offset + done) >> 32);
+            const auto chunk = size - done < 0x40000000 ? (DWORD)(size - done) : (DWORD)0x40000000;
+            DWORD n = 0;
+            if(!WriteFile(_h,(const uint8_t*)buf + done,chunk,&n,&ov) || n == 0)
+                break;
+#else
+            const auto n = ::pwrite(_h,(const uint8_t*)buf + done,size - done,(off_t)(offset + done));
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                break;
+#endif
+            done += (size_t)n;
+        }
+        return done;
+    }
+private:
+    static inline native_file_t invalid() {
+#ifdef _WIN32
+        return INVALID_HANDLE_VALUE;
+#else
+        return -1;
+#endif
+    }
+
+    inline void open(const std::string& path,unsigned flags) {
+        const bool write = (flags & file_write) != 0;
+        _direct = (flags & file_direct) && !write;
+#ifdef _WIN32
+        DWORD attr = FILE_ATTRIBUTE_NORMAL;
+        if(flags & file_sequential) attr |= FILE_FLAG_SEQUENTIAL_SCAN;
+        else if(flags & file_random) attr |= FILE_FLAG_RANDOM_ACCESS;
+        if(_direct) attr |= FILE_FLAG_NO_BUFFERING;
+        _h = CreateFileA(path.c_str(),write ? GENERIC_WRITE : GENERIC_READ,FILE_SHARE_READ,nullptr,
+                         write ? CREATE_ALWAYS : OPEN_EXISTING,attr,nullptr);
+#else
+        int of = (write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY) | O_CLOEXEC;
+#ifdef O_DIRECT
+        _h = _direct ? ::open(path.c_str(),of | O_DIRECT,0644) : -1;
+        if(_h < 0 && _direct && errno != EINVAL)
+            return;
+#endif
+        if(_h < 0) {
+            _h = ::open(path.c_str(),of,0644);   // O_DIRECT is refused by some file systems, e.g. tmpfs
+#ifdef F_NOCACHE
+            if(_h >= 0 && _direct && fcntl(_h,F_NOCACHE,1) == 0)
+                return;
+#endif
+            _direct = false;
+        }
+        if(_h < 0)
+            return;
+#ifdef POSIX_FADV_SEQUENTIAL
+        if(flags & file_sequential) posix_fadvise(_h,0,0,POSIX_FADV_SEQUENTIAL);
+        else if(flags & file_random) posix_fadvise(_h,0,0,POSIX_FADV_RANDOM);
+#endif
+#endif
     }
+
+    inline void close() {
+        if(!is_open() || !_own)
+            return;
+#ifdef _WIN32
+        CloseHandle(_h);
+#else
+        ::close(_h);
+#endif
+        _h = invalid();
+    }
+
+    native_file_t _h = invalid();
+    bool _direct = false;
+    bool _own = true;
 };
 
-inline writer<Buffer> make_writer(buffer_t& out)
-{ return { out }; }
+// a heap block aligned for file_direct, its size rounded up to a multiple
+struct aligned_block {
+    aligned_block(const aligned_block&) = delete;
+    inline aligned_block(aligned_block&& o) :
+        _data(o._data),_size(o._size)
+    {
+        o._data = nullptr;
+        o._size = 0;
+    }
+    inline explicit aligned_block(size_t size,size_t multiple = direct_align)
+        : _size((size + multiple - 1) / multiple * multiple)
+    {
+        _data = (uint8_t*)::operator new(_size,std::align_val_t(direct_align));
+    }
+    inline ~aligned_block() {
+        if(_data)
+            ::operator delete(_data,std::align_val_t(direct_align));
+    }
 
-inline writer<Stream> make_writer(std::ostream& si)
-{ return { si }; }
+    inline uint8_t* data() const {
+        return _data;
+    }
+    inline size_t size() const {
+        return _size;
+    }
+private:
+    uint8_t* _data;
+    size_t _size;
+};
+
+// read-ahead through pread / ReadFile at an offset: several readers share one raw_file
+// across threads, each with its own position and block. With file_direct the block is read
+// at aligned offsets, large reads go through it too; without, large reads bypass it
+template<typename I>
+struct basic_reader<File,I> : I {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(basic_reader&& o) :
+        _own(std::move(o._own)),_fh(o._fh == &o._own ? &_own : o._fh),_beg(o._beg),_end(o._end),
+        _blk(std::move(o._blk)),_at(o._at),_cur(o._cur),_len(o._len)
+    {
+        o._cur = o._len = 0;
+    }
+    // flags: file_sequential, file_random, file_direct
+    inline explicit basic_reader(const std::string& path,unsigned flags = file_read,
+                                 size_t block_size = default_block_size)
+        : _own(path,flags & ~file_write),_fh(&_own),_beg(0),_end(_own.size()),
+          _blk(block_size > 0 ? block_size : 1,_own.direct() ? direct_align : 64),_at(_beg)
+    {}
+    // the whole file of a shared handle
+    inline basic_reader(const raw_file& fh,size_t block_size = default_block_size)
+        : basic_reader(fh,0,fh.size(),block_size)
+    {}
+    // a window of size bytes from the offset beg of a shared handle
+    inline basic_reader(const raw_file& fh,size_t beg,size_t size,size_t block_size = default_block_size)
+        : _fh(&fh),_beg(beg),_end(beg + size),
+          _blk(block_size > 0 ? block_size : 1,fh.direct() ? direct_align : 64),_at(beg)
+    {}
+
+    inline bool is_open() const {
+        return _fh->is_open();
+    }
+
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        const auto avail = _len - _cur;
+        if(avail >= size) {
+            memcpy(buf,_blk.data() + _cur,size);
+            _cur += size;
+            return size;
+        }
+
+        memcpy(buf,_blk.data() + _cur,avail);
+        _cur = _len;
+        size_t done = avail;
+        while(done < size) {
+            const auto at = _at + _cur;
+            if(at >= _end)
+                break;
+            if(!_fh->direct() && size - done >= _blk.size()) {
+                auto n = size - done;
+                if(n > _end - at)
+                    n = _end - at;
+                n = _fh->read_at(buf + done,n,at);
+                count_transfer(*this);
+                _at = at + n;
+                _cur = _len = 0;
+                return done + n;
+            }
+            if(!refill())
+                break;
+            auto n = _len - _cur;
+            if(n > size - done)
+                n = size - done;
+            memcpy(buf + done,_blk.data() + _cur,n);
+            _cur += n;
+            done += n;
+        }
+        return done;
+    }
 
+    inline size_t pos() const {
+        return _at + _cur - _beg;
+    }
+
+    // check once that n bytes are available, reading a block at the position if needed, to read them
+    // without checks; the cursor is valid until the next call on the reader
+    // @return: a cursor over them, false if less than n bytes remain or n exceeds the block size
+    inline read_cursor ensure(size_t n) {
+        if(_len - _cur < n && (!refill() || _len - _cur < n))
+            return {};
+        return { _blk.data() + _cur,n,&_cur };
+    }
+
+    // pos < 0: to the end; others: to the pos
+    inline size_t seek(pos_t pos) {
+        const auto size = _end - _beg;
+        if(pos < 0 || (size_t)pos > size)
+            pos = (pos_t)size;
+        return move_to(_beg + (size_t)pos);
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
+
+    // a reader over [offset,offset + length) of this one, clamped to its end, with its own
+    // position and block; it uses the handle of this reader, which must outlive it
+    inline reader<File,I> slice(size_t offset,size_t length) {
+        const auto size = _end - _beg;
+        if(offset > size) offset = size;
+        if(length > size - offset) length = size - offset;
+        return { *_fh,_beg + offset,length,_blk.size() };
+    }
+private:
+    // the block is only dropped if the target is out of it
+    inline size_t move_to(size_t at) {
+        if(at >= _at && at <= _at + _len) {
+            _cur = at - _at;
+        } else {
+            _at = at;
+            _cur = _len = 0;
+        }
+        return at - _beg;
+    }
+
+    // read the block from the current position, the aligned one below it for file_direct
+    // @return: false if nothing is left
+    inline bool refill() {
+        const auto at = _at + _cur;
+        if(at >= _end)
+            return false;
+        auto base = at;
+        auto n = _blk.size();
+        if(_fh->direct()) {
+            base = at / direct_align * direct_align;
+        } else if(n > _end - at) {
+            n = _end - at;
+        }
+        n = _fh->read_at(_blk.data(),n,base);
+        count_transfer(*this);
+        if(n > _end - base)
+            n = _end - base;
+        _at = base;
+        _cur = at - base;
+        _len = n > _cur ? n : _cur;
+        return _len > _cur;
+    }
+
+    raw_file _own;           // closed if the handle is shared
+    const raw_file* _fh;
+    const size_t _beg;          // the offset of begin
+    const size_t _end;          // the offset of end
+    aligned_block _blk;         // read-ahead block
+    size_t _at;                 // the offset of block begin
+    size_t _cur = 0;            // current position in the block
+    size_t _len = 0;            // valid bytes in the block
+};
+
+// behaves like basic_reader<Buffer> over the whole file,
+// pages are loaded by the os on first access
+template<typename I>
+struct basic_reader<Mapped,I> : private mapped_file, public basic_reader<Buffer,I> {
+    basic_reader(const basic_reader&) = delete;
+    inline basic_reader(basic_reader&& o) :
+        mapped_file(std::move(o)),basic_reader<Buffer,I>(std::move(o))
+    {}
+    inline explicit basic_reader(const std::string& path) :
+        mapped_file(path),basic_reader<Buffer,I>(mapped_file::data(),mapped_file::size())
+    {}
+
+    using mapped_file::is_open;
+};
+
+// readers which can reference their bytes without copy
+template<typename R,typename = void>
+struct has_peek : std::false_type {};
+
+template<typename R>
+struct has_peek<R,std::void_t<decltype(std::declval<const R&>().peek(size_t()))>> : std::true_type {};
+
+// R counts the peeked bytes it moves past, see counted_reader
+template<typename R,typename = void>
+struct has_consume : std::false_type {};
+
+template<typename R>
+struct has_consume<R,std::void_t<decltype(std::declval<R&>().consume(size_t()))>> : std::true_type {};
+
+// move r past n bytes it has peeked
+template<typename R>
+inline void consume(R& r,size_t n) {
+    if constexpr(has_consume<R>::value) r.consume(n);
+    else r.offset((pos_t)n);
+}
+
+// B reports its own failures, e.g. the async writer
+template<typename B,typename = void>
+struct has_fail : std::false_type {};
+
+template<typename B>
+struct has_fail<B,std::void_t<decltype(std::declval<const B&>().fail())>> : std::true_type {};
+
+// writers which overwrite written bytes without seeking
+template<typename W,typename = void>
+struct has_patch : std::false_type {};
+
+template<typename W>
+struct has_patch<W,std::void_t<decltype(std::declval<W&>().patch(size_t(),(const uint8_t*)nullptr,size_t()))>>
+    : std::true_type {};
+
+// writers which keep their block in memory for the pending placeholders
+template<typename W,typename = void>
+struct has_pin : std::false_type {};
+
+template<typename W>
+struct has_pin<W,std::void_t<decltype(std::declval<W&>().pin())>> : std::true_type {};
+
+/////////////////////////////////////////////////////////////////////
+/// schema: declarative struct serialization
+/// e.g.
+///   struct Header { char tag[3]; uint32_t version; uint64_t count; };
+///   BIO_FIELDS(Header,tag,version,count)      // in the namespace of Header
+/// or with per-field coding:
+///   inline auto bio_fields(const Header*) {
+///       using namespace ck::bio;
+///       return std::make_tuple(field(&Header::tag),field_be(&Header::version),field_varint(&Header::count));
+///   }
+/// then reader::read(Header&) / writer::write(const Header&) follow the fields in order;
+/// runs of fixed size fields are read/written with one bounds check and one copy
+
+enum Coding
+{
+    AsNative,
+    AsLittle,
+    AsBig,
+    AsVarint
+};
+
+template<typename C,typename M,Coding E>
+struct field_t {
+    using member_type = M;
+    static constexpr Coding coding = E;
+    M C::* ptr;
+};
+
+template<typename C,typename M>
+constexpr field_t<C,M,AsNative> field(M C::* p) { return { p }; }
+
+template<typename C,typename M>
+constexpr field_t<C,M,AsLittle> field_le(M C::* p) { return { p }; }
+
+template<typename C,typename M>
+constexpr field_t<C,M,AsBig> field_be(M C::* p) { return { p }; }
+
+template<typename C,typename M>
+constexpr field_t<C,M,AsVarint> field_varint(M C::* p) { return { p }; }
+
+// T has a bio_fields(const T*) found by ADL
+template<typename T,typename = void>
+struct has_schema : std::false_type {};
+
+template<typename T>
+struct has_schema<T,std::void_t<decltype(bio_fields((const T*)nullptr))>> : std::true_type {};
+
+template<typename F>
+constexpr bool is_fixed_field = F::coding != AsVarint &&
+                                !has_schema<typename F::member_type>::value &&
+                                std::is_trivially_copyable<typename F::member_type>::value;
+
+// the end of the run of fixed fields begin at I
+template<typename Fs,size_t I>
+constexpr size_t fixed_run_end() {
+    if constexpr(I < std::tuple_size<Fs>::value) {
+        if constexpr(is_fixed_field<std::tuple_element_t<I,Fs>>)
+            return fixed_run_end<Fs,I + 1>();
+        else
+            return I;
+    } else {
+        return I;
+    }
+}
+
+// the encoded size of the fixed fields [B,E)
+template<typename Fs,size_t B,size_t E>
+constexpr size_t fixed_run_size() {
+    if constexpr(B < E)
+        return sizeof(typename std::tuple_element_t<B,Fs>::member_type) + fixed_run_size<Fs,B + 1,E>();
+    else
+        return 0;
+}
+
+template<typename Fs,size_t B,size_t J,size_t E,typename T>
+inline void unpack_fields(const uint8_t* p,T& obj,const Fs& fs) {
+    if constexpr(J < E) {
+        using F = std::tuple_element_t<J,Fs>;
+        auto& m = obj.*(std::get<J>(fs).ptr);
+        memcpy(&m,p + fixed_run_size<Fs,B,J>(),sizeof(m));
+        if constexpr(F::coding == AsLittle) m = convert_endian<LittleEndian>(m);
+        else if constexpr(F::coding == AsBig) m = convert_endian<BigEndian>(m);
+        unpack_fields<Fs,B,J + 1,E>(p,obj,fs);
+    }
 }
 
+template<typename Fs,size_t B,size_t J,size_t E,typename T>
+inline void pack_fields(uint8_t* p,const T& obj,const Fs& fs) {
+    if constexpr(J < E) {
+        using F = std::tuple_element_t<J,Fs>;
+        const auto& m = obj.*(std::get<J>(fs).ptr);
+        constexpr size_t ofs = fixed_run_size<Fs,B,J>();
+        if constexpr(F::coding == AsLittle || F::coding == AsBig) {
+            const auto v = convert_endian<F::coding == AsLittle ? LittleEndian : BigEndian>(m);
+            memcpy(p + ofs,&v,sizeof(v));
+        } else {
+            memcpy(p + ofs,&m,sizeof(m));
+        }
+        pack_fields<Fs,B,J + 1,E>(p,obj,fs);
+    }
 }
 
+template<size_t I,typename R,typename T,typename Fs>
+inline bool read_fields(R& r,T& obj,const Fs& fs,size_t& total) {
+    if constexpr(I < std::tuple_size<Fs>::value) {
+        using F = std::tuple_element_t<I,Fs>;
+        constexpr size_t E = is_fixed_field<F> ? fixed_run_end<Fs,I>() : I + 1;
+        if constexpr(is_fixed_field<F>) {
+            constexpr size_t size = fixed_run_size<Fs,I,E>();
+            if constexpr(has_peek<R>::value) {
+                const auto v = r.peek(size);
+                if(v.size != size)
+                    return false;
+                unpack_fields<Fs,I,I,E>(v.data,obj,fs);
+                consume(r,size);
+            } else {
+                uint8_t buf[size];
+                if(r.read(buf,size) != size)
+                    return false;
+                unpack_fields<Fs,I,I,E>(buf,obj,fs);
+            }
+            total += size;
+        } else {
+            auto& m = obj.*(std::get<I>(fs).ptr);
+            size_t n;
+            if constexpr(F::coding == AsVarint) n = r.read_varint(m);
+            else n = r.read(m);
+            if(n < 1)
+                return false;
+            total += n;
+        }
+        return read_fields<E>(r,obj,fs,total);
+    } else {
+        return true;
+    }
+}
+
+template<size_t I,typename W,typename T,typename Fs>
+inline bool write_fields(W& w,const T& obj,const Fs& fs,size_t& total) {
+    if constexpr(I < std::tuple_size<Fs>::value) {
+        using F = std::tuple_element_t<I,Fs>;
+        constexpr size_t E = is_fixed_field<F> ? fixed_run_end<Fs,I>() : I + 1;
+        if constexpr(is_fixed_field<F>) {
+            constexpr size_t size = fixed_run_size<Fs,I,E>();
+            uint8_t buf[size];
+            pack_fields<Fs,I,I,E>(buf,obj,fs);
+            if(w.write(buf,size) != size)
+                return false;
+            total += size;
+        } else {
+            auto& m = obj.*(std::get<I>(fs).ptr);
+            size_t n;
+            if constexpr(F::coding == AsVarint) n = w.write_varint(m);
+            else n = w.write(m);
+            if(n < 1)
+                return false;
+            total += n;
+        }
+        return write_fields<E>(w,obj,fs,total);
+    } else {
+        return true;
+    }
+}
+
+// @return: the number of bytes have been read, 0 if any field failed
+template<typename R,typename T>
+inline size_t read_schema(R& r,T& obj) {
+    size_t total = 0;
+    return read_fields<0>(r,obj,bio_fields((const T*)nullptr),total) ? total : 0;
+}
+
+// @return: the number of bytes have been written, 0 if any field failed
+template<typename W,typename T>
+inline size_t write_schema(W& w,const T& obj) {
+    size_t total = 0;
+    return write_fields<0>(w,obj,bio_fields((const T*)nullptr),total) ? total : 0;
+}
+
+// length prefix of strings and containers, the fixed ones are little endian
+enum Prefix
+{
+    PrefixVarint,
+    PrefixU8,
+    PrefixU16,
+    PrefixU32,
+    PrefixU64
+};
+
+// types read/written with a length prefix
+template<typename T>
+struct is_prefixed : std::false_type {};
+
+template<typename C,typename Tr,typename A>
+struct is_prefixed<std::basic_string<C,Tr,A>> : std::true_type {};
+
+template<typename T,typename A>
+struct is_prefixed<std::vector<T,A>> : std::true_type {};
+
+template<typename K,typename V,typename C,typename A>
+struct is_prefixed<std::map<K,V,C,A>> : std::true_type {};
+
+template<typename K,typename V,typename H,typename E,typename A>
+struct is_prefixed<std::unordered_map<K,V,H,E,A>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_bulk_element = std::is_trivially_copyable<T>::value && !has_schema<T>::value;
+
+// the typed api over a byte reader B: a basic_reader, or a filter such as lz4_reader
+template<typename B>
+struct typed_reader : public B {
+    using super = B;
+    using B::B;
+
+    // a short read sets the sticky fail flag and zero-fills the rest of out; once failed, reads
+    // zero-fill and return 0, so a decode sequence can be checked once at its end by fail()
+    template<typename T>
+    inline size_t read(T* out, size_t capacity) {
+        if(!_failed) {
+            const auto n = super::read((uint8_t*)out,capacity);
+            if(n == capacity)
+                return n;
+            return short_read((uint8_t*)out,n,capacity);
+        }
+        return short_read((uint8_t*)out,0,capacity);
+    }
+
+    template<typename T>
+    size_t read(T* out) {
+        return read(out,sizeof(T));
+    }
+
+    // T with a schema follows its fields, see BIO_FIELDS; others are read as raw bytes
+    template<typename T>
+    inline size_t read(T& out) {
+        if constexpr(has_schema<T>::value) {
+            const auto n = _failed ? 0 : read_schema(*this,out);
+            return n > 0 ? n : set_fail();
+        } else {
+            static_assert(!std::is_pointer<T>::value,"read(out,size) for the bytes a pointer points to");
+            static_assert(std::is_trivially_copyable<T>::value,"T must be trivially copyable");
+            // once failed, the source is not touched
+            if(_failed) {
+                memset(&out,0,sizeof(T));
+                return 0;
+            }
+            const auto n = super::read((uint8_t*)&out,sizeof(T));
+            if(n != sizeof(T)) {
+                memset(&out,0,sizeof(T));
+                _failed = true;
+            }
+            return n;
+        }
+    }
+
+    // read a value stored in E byte order
+    // @return: sizeof(T) if success, the out is zero otherwise
+    template<Endian E,typename T>
+    inline size_t read(T& out) {
+        const auto n = read(out);
+        out = convert_endian<E>(out);
+        return n;
+    }
+
+    template<typename T>
+    inline size_t read_le(T& out) {
+        return read<LittleEndian>(out);
+    }
+
+    template<typename T>
+    inline size_t read_be(T& out) {
+        return read<BigEndian>(out);
+    }
+
+    // read count elements stored in e byte order with one transfer, then swap them in place
+    // @return: the number of elements have been read
+    template<typename T>
+    inline size_t read_array(T* out,size_t count,Endian e = NativeEndian) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,"T must be arithmetic or enum");
+        const auto n = read(out,count * sizeof(T)) / sizeof(T);
+        if(e != NativeEndian)
+            swap_bytes(out,n);
+        return n;
+    }
+
+    // read a LEB128 varint, zigzag for signed T;
+    // in-memory modes decode straight from the source
+    // @return: the number of bytes consumed, 0 if failed and out is zero
+    template<typename T>
+    inline size_t read_varint(T& out) {
+        if(_failed) {
+            out = 0;
+            return 0;
+        }
+        if constexpr(has_peek<super>::value) {
+            const auto v = super::peek(varint_max_size<T>);
+            const auto n = decode_varint(v.data,v.size,out);
+            if(n > 0) {
+                bio::consume((super&)*this,n);
+                return n;
+            }
+        } else {
+            uint8_t buf[varint_max_size<T>];
+            for(size_t n = 0; n < sizeof(buf); ++n) {
+                if(super::read(buf + n,1) != 1)
+                    break;
+                if(!(buf[n] & 0x80)) {
+                    const auto k = decode_varint(buf,n + 1,out);
+                    if(k > 0)
+                        return k;
+                    break;
+                }
+            }
+        }
+        out = 0;
+        return set_fail();
+    }
+
+    // @return: the number of bytes consumed, 0 if failed
+    inline size_t read_length(size_t& out,Prefix p = PrefixVarint) {
+        switch(p) {
+        case PrefixU8: return read_length_as<uint8_t>(out);
+        case PrefixU16: return read_length_as<uint16_t>(out);
+        case PrefixU32: return read_length_as<uint32_t>(out);
+        case PrefixU64: return read_length_as<uint64_t>(out);
+        default: return read_varint(out);
+        }
+    }
+
+    // length prefixed strings and containers; the existing capacity of out is reused
+    // @return: the number of bytes consumed, 0 if failed
+    template<typename C,typename Tr,typename A>
+    inline size_t read(std::basic_string<C,Tr,A>& out,Prefix p = PrefixVarint) {
+        size_t n;
+        const auto k = read_length(n,p);
+        if(k < 1)
+            return 0;
+        const auto m = read_bulk(out,n);
+        return m == n * sizeof(C) ? k + m : set_fail();
+    }
+
+    template<typename T,typename A>
+    inline size_t read(std::vector<T,A>& out,Prefix p = PrefixVarint) {
+        size_t n;
+        const auto k = read_length(n,p);
+        if(k < 1)
+            return 0;
+        if constexpr(is_bulk_element<T>) {
+            const auto m = read_bulk(out,n);
+            return m == n * sizeof(T) ? k + m : set_fail();
+        } else {
+            if(out.size() > n)
+                out.resize(n);
+            size_t total = k;
+            for(size_t i = 0; i < n; ++i) {
+                if(i == out.size())     // grow with the data really read, not the prefix
+                    out.resize(n - i < out.size() + 16 ? n : out.size() * 2 + 16);
+                const auto m = read_item(out[i],p);
+                if(m < 1) {
+                    out.resize(i);
+                    return set_fail();
+                }
+                total += m;
+            }
+            return total;
+        }
+    }
+
+    template<typename K,typename V,typename C,typename A>
+    inline size_t read(std::map<K,V,C,A>& out,Prefix p = PrefixVarint) {
+        return read_map(out,p);
+    }
+
+    template<typename K,typename V,typename H,typename E,typename A>
+    inline size_t read(std::unordered_map<K,V,H,E,A>& out,Prefix p = PrefixVarint) {
+        return read_map(out,p);
+    }
+
+    // zero-copy string for in-memory modes, valid as long as the source
+    // @return: the number of bytes consumed, 0 if failed
+    inline size_t read_string_view(std::string_view& out,Prefix p = PrefixVarint) {
+        static_assert(has_peek<super>::value,"only for in-memory modes");
+        size_t n;
+        const auto k = read_length(n,p);
+        if(k < 1)
+            return 0;
+        const auto v = super::view(n);
+        if(v.size != n)
+            return set_fail();
+        out = std::string_view((const char*)v.data,v.size);
+        return k + n;
+    }
+
+    // true once a read was short or a decode failed
+    inline bool fail() const {
+        return _failed;
+    }
+
+    inline bool good() const {
+        return !_failed;
+    }
+
+    inline explicit operator bool() const {
+        return !_failed;
+    }
+
+    // reset the fail flag, e.g. after seeking back
+    inline void clear_fail() {
+        _failed = false;
+    }
+private:
+    inline size_t set_fail() {
+        _failed = true;
+        return 0;
+    }
+
+    // zero-fill out[n,capacity) and fail, out of line to keep the reads small
+    BIO_NOINLINE size_t short_read(uint8_t* out,size_t n,size_t capacity) {
+        _failed = true;
+        if(n < capacity)
+            memset(out + n,0,capacity - n);
+        return n;
+    }
+
+    template<typename U>
+    inline size_t read_length_as(size_t& out) {
+        U v;
+        const auto k = read_le(v);
+        if(k != sizeof(U) || (uint64_t)v > (uint64_t)SIZE_MAX)
+            return set_fail();
+        out = (size_t)v;
+        return k;
+    }
+
+    template<typename T>
+    inline size_t read_item(T& out,Prefix p) {
+        if constexpr(is_prefixed<T>::value) return read(out,p);
+        else return read(out);
+    }
+
+    // read n trivially copyable elements to out, a corrupt n cannot allocate more than the data
+    // @return: the number of bytes have been read
+    template<typename C>
+    inline size_t read_bulk(C& out,size_t n) {
+        using T = typename C::value_type;
+        if(n > SIZE_MAX / sizeof(T))
+            return set_fail();
+        if constexpr(has_peek<super>::value) {
+            const auto v = super::peek(n * sizeof(T));
+            if(v.size != n * sizeof(T))
+                return set_fail();
+            out.resize(n);
+            if(n > 0)
+                memcpy(&out[0],v.data,v.size);
+            bio::consume((super&)*this,v.size);
+            return v.size;
+        } else {
+            constexpr size_t chunk = 65536 / sizeof(T) > 0 ? 65536 / sizeof(T) : 1;
+            if(out.size() > n || n <= chunk)
+                out.resize(n);
+            size_t done = 0;
+            while(done < n) {
+                const auto m = n - done < chunk ? n - done : chunk;
+                if(out.size() < done + m)
+                    out.resize(done + m);
+                const auto r = read(&out[done],m * sizeof(T));
+                if(r != m * sizeof(T)) {
+                    out.resize(done + r / sizeof(T));
+                    return done * sizeof(T) + r;
+                }
+                done += m;
+            }
+            return n * sizeof(T);
+        }
+    }
+
+    template<typename M>
+    inline size_t read_map(M& out,Prefix p) {
+        size_t n;
+        const auto k = read_length(n,p);
+        if(k < 1)
+            return 0;
+        out.clear();
+        size_t total = k;
+        for(size_t i = 0; i < n; ++i) {
+            typename M::key_type key{};
+            typename M::mapped_type value{};
+            const auto a = read_item(key,p);
+            const auto b = a > 0 ? read_item(value,p) : 0;
+            if(b < 1)
+                return set_fail();
+            out.emplace_hint(out.end(),std::move(key),std::move(value));
+            total += a + b;
+        }
+        return total;
+    }
+
+    bool _failed = false;
+};
+
+template<Mode MO,typename I>
+struct reader : public typed_reader<counted_reader_t<basic_reader<MO,I>>> {
+    using typed_reader<counted_reader_t<basic_reader<MO,I>>>::typed_reader;
+};
+
+// readers without vtable, see direct
+template<Mode MO>
+using fast_reader = reader<MO,direct>;
+
+// type-erased adapter, for passing a fast_reader to code that needs ireader
+template<typename R>
+struct ireader_ref : ireader {
+    inline ireader_ref(R& r) : _r(r) {}
+
+    inline size_t read(uint8_t* buf,size_t size) override { return _r.read(buf,size); }
+    inline size_t pos() const override { return _r.pos(); }
+    inline size_t seek(pos_t pos) override { return _r.seek(pos); }
+    inline size_t offset(pos_t ofs) override { return _r.offset(ofs); }
+private:
+    R& _r;
+};
+
+// I = direct to make a fast_reader
+template<typename I = ireader>
+inline reader<Buffer,I> make_reader(const uint8_t* in,size_t in_size)
+{ return { in,in_size }; }
+
+template<typename I = ireader>
+inline reader<Buffer,I> make_reader(const buffer_t* in)
+{ return { in }; }
+
+template<typename I = ireader>
+inline reader<Stream,I> make_reader(std::istream& si)
+{ return { si }; }
+
+// size: the length from the current position, so the end of stream is not probed
+template<typename I = ireader>
+inline reader<Stream,I> make_reader(std::istream& si,size_t size)
+{ return { si,size }; }
+
+// the streambuf of si directly, see Streambuf
+template<typename I = ireader>
+inline reader<Streambuf,I> make_streambuf_reader(std::istream& si)
+{ return { si }; }
+
+template<typename I = ireader>
+inline reader<Streambuf,I> make_streambuf_reader(std::istream& si,size_t size)
+{ return { si,size }; }
+
+template<typename I = ireader>
+inline reader<ForwardStream,I> make_forward_reader(std::istream& si,size_t size = unknown_size,
+                                                    size_t block_size = default_block_size)
+{ return { si,size,block_size }; }
+
+template<typename I = ireader>
+inline reader<Mapped,I> make_mapped_reader(const std::string& path)
+{ return reader<Mapped,I>{ path }; }
+
+// flags: file_sequential, file_random, file_direct
+template<typename I = ireader>
+inline reader<File,I> make_file_reader(const std::string& path,unsigned flags = file_read,
+                                       size_t block_size = default_block_size)
+{ return reader<File,I>{ path,flags,block_size }; }
+
+template<typename I = ireader>
+inline reader<BufferedStream,I> make_buffered_reader(std::istream& si,size_t block_size = default_block_size)
+{ return { si,block_size }; }
+
+template<typename I = ireader>
+inline reader<AsyncStream,I> make_async_reader(std::istream& si,size_t block_size = default_block_size)
+{ return { si,block_size }; }
+
+/////////////////////////////////////////////////////////////////////
+/// writer
+struct iwriter{
+    virtual void reserve(size_t) {};
+    virtual size_t write(const uint8_t* buf,size_t size) = 0;
+    virtual size_t pos() const = 0;
+    virtual size_t seek(pos_t pos) = 0;
+    virtual size_t offset(pos_t ofs) = 0;
+};
+
+template<Mode MO,typename I = iwriter>
+struct basic_writer
+{};
+
+// byte container the buffer writer can target: data(), size(), capacity(), resize(), reserve()
+// e.g. buffer_t, raw_buffer_t, std::string, std::pmr::vector<uint8_t>
+template<typename C,typename = void>
+struct is_byte_container : std::false_type {};
+
+template<typename C>
+struct is_byte_container<C,std::void_t<
+        decltype(std::declval<C&>().data()),
+        decltype(std::declval<C&>().resize(size_t())),
+        decltype(std::declval<C&>().reserve(size_t())),
+        decltype(std::declval<const C&>().capacity()),
+        typename C::value_type>>
+    : std::bool_constant<sizeof(typename C::value_type) == 1 &&
+                         std::is_trivially_copyable<typename C::value_type>::value> {};
+
+// type-erased container operations, only used when a write extends the buffer
+struct buffer_ops {
+    size_t (*capacity)(const void* c);
+    uint8_t* (*resize)(void* c,size_t size);        // @return: data() after
+    uint8_t* (*reserve)(void* c,size_t capacity);   // @return: data() after
+    uint8_t* (*shrink_to_fit)(void* c);             // @return: data() after
+
+    template<typename C>
+    static inline const buffer_ops* of() {
+        static const buffer_ops ops {
+            [](const void* c) { return (size_t)((const C*)c)->capacity(); },
+            [](void* c,size_t size) { ((C*)c)->resize(size); return (uint8_t*)((C*)c)->data(); },
+            [](void* c,size_t capacity) { ((C*)c)->reserve(capacity); return (uint8_t*)((C*)c)->data(); },
+            [](void* c) { ((C*)c)->shrink_to_fit(); return (uint8_t*)((C*)c)->data(); }
+        };
+        return &ops;
+    }
+};
+
+// the container always holds exactly the written bytes, size() of it is size() of the writer;
+// the capacity grows geometrically by reserve(), so extending it only resizes in place.
+// the container must not be modified but through the writer while the writer lives
+template<typename I>
+struct basic_writer<Buffer,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _buf(o._buf),_ops(o._ops),_data(o._data),_cap(o._cap),_cur(o._cur),_size(o._size)
+    {
+        o._buf = nullptr;
+        o._data = nullptr;
+        o._cap = o._cur = o._size = 0;
+    }
+    template<typename C,typename = std::enable_if_t<is_byte_container<C>::value>>
+    inline basic_writer(C& buf)
+        : _buf(&buf),_ops(buffer_ops::of<C>()),
+          _data((uint8_t*)buf.data()),_cap(buf.capacity()),_cur(0),_size(buf.size())
+    {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        const auto need = _cur + size;
+        if(need > _size) {
+            if(need > _cap) grow(need);
+            _data = _ops->resize(_buf,need);
+            _size = need;
+        }
+        memcpy(_data + _cur,buf,size);
+        _cur = need;
+        return size;
+    }
+
+    inline void reserve(size_t capacity) {
+        if(!_buf || capacity <= _cap) return;
+        _data = _ops->reserve(_buf,capacity);
+        _cap = _ops->capacity(_buf);
+    }
+
+    // nothing to cut, the container holds only the written bytes; kept for writers finished alike
+    inline void finish() {}
+
+    // release the unused capacity
+    inline void shrink_to_fit() {
+        if(!_buf) return;
+        _data = _ops->shrink_to_fit(_buf);
+        _cap = _ops->capacity(_buf);
+    }
+
+    // the number of bytes have been written
+    inline size_t size() const {
+        return _size;
+    }
+
+    // overwrite n written bytes at pos in memory, the position is not moved
+    // @return: false if [pos,pos + n) is not written yet
+    inline bool patch(size_t pos,const uint8_t* data,size_t n) {
+        if(pos > _size || n > _size - pos)
+            return false;
+        memcpy(_data + pos,data,n);
+        return true;
+    }
+
+    inline size_t pos() const {
+        return _cur;
+    }
+
+    inline size_t seek(pos_t pos) {
+        _cur = _size;   // cannot move out size
+        if(pos >= 0 && (size_t)pos < _size)
+            _cur = (size_t)pos;
+        return this->pos();
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)_cur + ofs;
+        if(cur < 0) _cur = 0;
+        else if((size_t)cur > _size) _cur = _size;  // cannot move out size
+        else _cur = (size_t)cur;
+        return this->pos();
+    }
+private:
+    // doubles the capacity, at least to need
+    BIO_NOINLINE void grow(size_t need) {
+        auto cap = _cap * 2;
+        if(cap < need) cap = need;
+        if(cap < 64) cap = 64;
+        _ops->reserve(_buf,cap);
+        _cap = _ops->capacity(_buf);
+    }
+
+    void* _buf;                 // the target container
+    const buffer_ops* _ops;
+    uint8_t* _data;             // cached data() of the container
+    size_t _cap;                // cached capacity() of the container
+    size_t _cur;
+    size_t _size;               // cached size() of the container, the written bytes
+};
+
+template<typename I>
+struct basic_writer<Stream,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _so(o._so),_beg(o._beg)
+    {}
+    inline basic_writer(std::ostream& so)
+        : _so(so),_beg((size_t)so.tellp())
+    {}
+
+    inline void reserve(size_t) {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || _so.fail() || size < 1)
+            return 0;
+
+        const auto before = _so.tellp();
+        _so.write((char*)buf,size);
+        count_transfer(*this);
+        auto pos = _so.tellp();
+        if(pos == (std::streamsize)-1)
+            return 0;
+        return size_t(pos - before);
+    }
+
+    inline size_t pos() const {
+        return (size_t)_so.tellp() - _beg;
+    }
+
+    inline size_t seek(pos_t pos) {
+        _so.seekp(0,std::ios::end);
+        const auto tail = _so.tellp();
+        if(pos >= 0)
+        {
+            pos += _beg;
+            if(pos < tail)
+                _so.seekp(pos,std::ios::beg);
+        }
+        return this->pos();
+    }
+
+    inline size_t offset(pos_t ofs) {
+        _so.seekp(ofs,std::ios::cur);
+        return this->pos();
+    }
+
+    // overwrite n written bytes at pos, the position is not moved
+    // @return: false if the stream failed
+    inline bool patch(size_t pos,const uint8_t* data,size_t n) {
+        const auto at = _so.tellp();
+        _so.seekp(_beg + pos,std::ios::beg);
+        _so.write((const char*)data,n);
+        count_transfer(*this);
+        _so.seekp(at);
+        return !_so.fail();
+    }
+private:
+    std::ostream& _so;
+    const size_t _beg;  // the position of begin
+};
+
+// the position and the size are tracked here, so only a seek calls pubseekoff/pubseekpos of the streambuf
+template<typename I>
+struct basic_writer<Streambuf,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _sb(o._sb),_beg(o._beg),_pos(o._pos),_size(o._size)
+    {}
+    inline basic_writer(std::streambuf& sb)
+        : _sb(sb)
+    {
+        const auto at = sb.pubseekoff(0,std::ios::cur,std::ios::out);
+        _beg = at < 0 ? 0 : (size_t)at;
+        const auto end = sb.pubseekoff(0,std::ios::end,std::ios::out);
+        _size = end < 0 ? 0 : (size_t)end - _beg;
+        if(at >= 0)
+            sb.pubseekpos(at,std::ios::out);
+    }
+    // the streambuf of so, e.g. std::ofstream or std::stringstream
+    inline basic_writer(std::ostream& so)
+        : basic_writer(*so.rdbuf())
+    {}
+
+    inline void reserve(size_t) {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        size_t n = 0;
+        if(size <= streambuf_small_size) {
+            for(; n < size; ++n) {
+                if(_sb.sputc((char)buf[n]) == std::streambuf::traits_type::eof())
+                    break;
+            }
+        } else {
+            n = (size_t)_sb.sputn((const char*)buf,(std::streamsize)size);
+            count_transfer(*this);
+        }
+        _pos += n;
+        if(_pos > _size) _size = _pos;
+        return n;
+    }
+
+    inline size_t pos() const {
+        return _pos;
+    }
+
+    // pos < 0 or out of size: to the end
+    inline size_t seek(pos_t pos) {
+        const auto to = pos >= 0 && (size_t)pos < _size ? (size_t)pos : _size;
+        if(_sb.pubseekpos(_beg + to,std::ios::out) >= 0)
+            _pos = to;
+        return _pos;
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)_pos + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
+
+    // overwrite n written bytes at pos, the position is not moved
+    // @return: false if the streambuf failed
+    inline bool patch(size_t pos,const uint8_t* data,size_t n) {
+        if(pos > _size || n > _size - pos)
+            return false;
+        if(_sb.pubseekpos(_beg + pos,std::ios::out) < 0)
+            return false;
+        const auto ok = (size_t)_sb.sputn((const char*)data,(std::streamsize)n) == n;
+        count_transfer(*this);
+        return (_sb.pubseekpos(_beg + _pos,std::ios::out) >= 0) & ok;
+    }
+private:
+    std::streambuf& _sb;
+    size_t _beg;        // the position of begin
+    size_t _pos = 0;
+    size_t _size;       // the end of written bytes
+};
+
+// write-behind through pwrite / WriteFile at an offset, so the file position is never used:
+// seek() and patch() only move or write at offsets, several writers may write disjoint ranges
+// of one shared handle. file_direct is not used for writing
+template<typename I>
+struct basic_writer<File,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _own(std::move(o._own)),_fh(o._fh == &o._own ? &_own : o._fh),_beg(o._beg),_size(o._size),
+        _blk(std::move(o._blk)),_pos(o._pos),_cur(o._cur),_len(o._len),_failed(o._failed)
+    {
+        o._cur = o._len = 0;
+    }
+    // create or truncate the file at path
+    inline explicit basic_writer(const std::string& path,size_t block_size = default_block_size)
+        : _own(path,file_write),_fh(&_own),_beg(0),_blk(block_size > 0 ? block_size : 1),
+          _failed(!_own.is_open())
+    {}
+    // write from the offset beg of a shared handle, the bytes after beg count as written
+    inline basic_writer(const raw_file& fh,size_t beg = 0,size_t block_size = default_block_size)
+        : _fh(&fh),_beg(beg),_blk(block_size > 0 ? block_size : 1),_failed(!fh.is_open())
+    {
+        const auto size = fh.size();
+        _size = size > beg ? size - beg : 0;
+    }
+    inline ~basic_writer() {
+        spill();
+    }
+
+    inline bool is_open() const {
+        return _fh->is_open();
+    }
+
+    // true once a write to the file was short
+    inline bool fail() const {
+        return _failed;
+    }
+
+    inline void reserve(size_t) {}
+
+    // small writes are gathered in the block, large ones bypass it
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        if(_blk.size() - _cur < size) {
+            if(!spill())
+                return 0;
+            if(size >= _blk.size()) {
+                const auto n = _fh->write_at(buf,size,_beg + _pos);
+                count_transfer(*this);
+                _failed |= n != size;
+                _pos += n;
+                if(_pos > _size) _size = _pos;
+                return n;
+            }
+        }
+        memcpy(_blk.data() + _cur,buf,size);
+        _cur += size;
+        if(_cur > _len) _len = _cur;
+        return size;
+    }
+
+    // write the block to the file, no fsync
+    // @return: false if a write failed
+    inline bool flush() {
+        return spill();
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    inline size_t seek(pos_t pos) {
+        const auto end = tail();    // cannot move out size
+        if(pos < 0 || (size_t)pos > end)
+            pos = (pos_t)end;
+        return move_to((size_t)pos);
+    }
+
+    inline size_t offset(pos_t ofs) {
+        const auto end = tail();    // cannot move out size
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        else if((size_t)cur > end) cur = (pos_t)end;
+        return move_to((size_t)cur);
+    }
+
+    // overwrite n written bytes at pos, the position is not moved;
+    // in the block if it is still there, at the offset in the file otherwise
+    // @return: false if [pos,pos + n) is not written yet or the write failed
+    inline bool patch(size_t pos,const uint8_t* data,size_t n) {
+        if(pos >= _pos && n <= _len && pos - _pos <= _len - n) {
+            memcpy(_blk.data() + (pos - _pos),data,n);
+            return true;
+        }
+        if(pos > tail() || n > tail() - pos)
+            return false;
+        if(pos < _pos + _len && pos + n > _pos && !spill())
+            return false;   // partly in the block
+        const auto ok = _fh->write_at(data,n,_beg + pos) == n;
+        count_transfer(*this);
+        _failed |= !ok;
+        return ok;
+    }
+private:
+    inline size_t tail() const {
+        return _pos + _len > _size ? _pos + _len : _size;
+    }
+
+    inline size_t move_to(size_t pos) {
+        if(pos >= _pos && pos <= _pos + _len) {
+            _cur = pos - _pos;
+            return pos;
+        }
+        spill();
+        _pos = pos;
+        return pos;
+    }
+
+    // write the block out, the block will begin at the current position
+    inline bool spill() {
+        if(_len < 1)
+            return !_failed;
+        const auto n = _fh->write_at(_blk.data(),_len,_beg + _pos);
+        count_transfer(*this);
+        _failed |= n != _len;
+        _size = tail();
+        _pos += _cur;
+        _cur = _len = 0;
+        return !_failed;
+    }
+
+    raw_file _own;           // closed if the handle is shared
+    const raw_file* _fh;
+    const size_t _beg;          // the offset of begin
+    size_t _size = 0;           // the file size from begin
+    buffer_t _blk;              // write-behind block
+    size_t _pos = 0;            // the position of block begin
+    size_t _cur = 0;            // current position in the block
+    size_t _len = 0;            // valid bytes in the block
+    bool _failed;
+};
+
+template<typename I>
+struct basic_writer<BufferedStream,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _so(o._so),_beg(o._beg),_size(o._size),_block(o._block),_max_pinned(o._max_pinned),
+        _blk(std::move(o._blk)),_pos(o._pos),_cur(o._cur),_len(o._len),_pins(o._pins)
+    {
+        o._cur = o._len = o._pins = 0;
+    }
+    // max_pinned: the block may grow so large while placeholders are pending, see pin()
+    inline basic_writer(std::ostream& so,size_t block_size = default_block_size,size_t max_pinned = 1 << 20)
+        : _so(so),_beg((size_t)so.tellp()),_block(block_size > 0 ? block_size : 1),
+          _max_pinned(max_pinned),_blk(_block)
+    {
+        so.seekp(0,std::ios::end);
+        _size = (size_t)so.tellp() - _beg;
+        so.seekp(_beg,std::ios::beg);
+    }
+    inline ~basic_writer() {
+        spill();
+    }
+
+    inline void reserve(size_t) {}
+
+    // small writes are gathered in the block, large ones bypass it
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        if(_blk.size() - _cur < size) {
+            if(_pins > 0 && _cur + size <= _max_pinned) {
+                // placeholders pending: grow to keep them in memory
+                auto n = _blk.size() * 2;
+                if(n < _cur + size) n = _cur + size;
+                _blk.resize(n < _max_pinned ? n : _max_pinned);
+            } else {
+                if(!spill())
+                    return 0;
+                if(size >= _blk.size()) {
+                    _so.write((const char*)buf,size);
+                    count_transfer(*this);
+                    if(_so.fail())
+                        return 0;
+                    _pos += size;
+                    if(_pos > _size) _size = _pos;
+                    return size;
+                }
+            }
+        }
+        memcpy(_blk.data() + _cur,buf,size);
+        _cur += size;
+        if(_cur > _len) _len = _cur;
+        return size;
+    }
+
+    // write the block to the stream and flush the stream
+    // @return: false if the stream failed
+    inline bool flush() {
+        if(!spill())
+            return false;
+        _so.flush();
+        return !_so.fail();
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    // the stream is only seeked if the target is out of the block
+    inline size_t seek(pos_t pos) {
+        const auto end = tail();    // cannot move out size
+        if(pos < 0 || (size_t)pos > end)
+            pos = (pos_t)end;
+        return move_to((size_t)pos);
+    }
+
+    inline size_t offset(pos_t ofs) {
+        const auto end = tail();    // cannot move out size
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        else if((size_t)cur > end) cur = (pos_t)end;
+        return move_to((size_t)cur);
+    }
+
+    // overwrite n written bytes at pos, the position is not moved;
+    // in the block if it is still there, through the stream otherwise
+    // @return: false if [pos,pos + n) is not written yet or the stream failed
+    inline bool patch(size_t pos,const uint8_t* data,size_t n) {
+        if(pos >= _pos && n <= _len && pos - _pos <= _len - n) {
+            memcpy(_blk.data() + (pos - _pos),data,n);
+            return true;
+        }
+        if(pos > tail() || n > tail() - pos)
+            return false;
+        if(!spill())
+            return false;
+        _so.seekp(_beg + pos,std::ios::beg);
+        _so.write((const char*)data,n);
+        count_transfer(*this);
+        _so.seekp(_beg + _pos,std::ios::beg);
+        return !_so.fail();
+    }
+
+    // while pinned, the block grows instead of being written, up to max_pinned,
+    // so the placeholders in it are patched in memory; unpin() when they are filled
+    inline void pin() {
+        ++_pins;
+    }
+
+    inline void unpin() {
+        if(_pins > 0)
+            --_pins;
+    }
+private:
+    inline size_t tail() const {
+        return _pos + _len > _size ? _pos + _len : _size;
+    }
+
+    inline size_t move_to(size_t pos) {
+        if(pos >= _pos && pos <= _pos + _len) {
+            _cur = pos - _pos;
+            return pos;
+        }
+        spill();
+        _so.seekp(_beg + pos,std::ios::beg);
+        _pos = pos;
+        return pos;
+    }
+
+    // write the block out, the block will begin at the current position
+    inline bool spill() {
+        if(_len < 1)
+            return !_so.fail();
+        _so.write((const char*)_blk.data(),_len);
+        count_transfer(*this);
+        _size = tail();
+        if(_cur != _len)
+            _so.seekp(_beg + _pos + _cur,std::ios::beg);
+        _pos += _cur;
+        _cur = _len = 0;
+        if(_blk.size() > _block)
+            _blk.resize(_block);    // back from pinning, the capacity is kept
+        return !_so.fail();
+    }
+
+    std::ostream& _so;
+    const size_t _beg;  // the position of begin
+    size_t _size = 0;   // the stream size from begin
+    const size_t _block;        // the block size
+    const size_t _max_pinned;   // the largest block while pinned
+    buffer_t _blk;      // write-behind block
+    size_t _pos = 0;    // the position of block begin
+    size_t _cur = 0;    // current position in the block
+    size_t _len = 0;    // valid bytes in the block
+    size_t _pins = 0;   // pending placeholders
+};
+
+// write-behind: filled blocks go to a background thread through a bounded lock-free spsc queue,
+// write only blocks while the queue is full; flush()/destruction wait for the thread.
+// the stream must not be used by others until the writer is destroyed
+template<typename I>
+struct basic_writer<AsyncStream,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    // depth: the number of blocks in the queue
+    inline basic_writer(std::ostream& so,size_t block_size = default_block_size,size_t depth = 4)
+        : _so(so),_beg((size_t)so.tellp()),_slots(depth > 1 ? depth : 2)
+    {
+        so.seekp(0,std::ios::end);
+        _size = (size_t)so.tellp() - _beg;
+        so.seekp(_beg,std::ios::beg);
+        for(auto& sl : _slots)
+            sl.buf.resize(block_size > 0 ? block_size : 1);
+        _worker = std::thread([this]{ run(); });
+    }
+    inline ~basic_writer() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv_data.notify_one();
+        _worker.join();
+    }
+
+    inline void reserve(size_t) {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1 || _failed.load(std::memory_order_relaxed))
+            return 0;
+        auto* blk = &_slots[_t % _slots.size()].buf;
+        if(blk->size() - _cur >= size) {
+            memcpy(blk->data() + _cur,buf,size);
+            _cur += size;
+            if(_cur > _len) _len = _cur;
+            return size;
+        }
+        size_t done = 0;
+        while(done < size) {
+            if(_cur == blk->size()) {
+                publish();
+                blk = &_slots[_t % _slots.size()].buf;
+            }
+            auto n = blk->size() - _cur;
+            if(n > size - done)
+                n = size - done;
+            memcpy(blk->data() + _cur,buf + done,n);
+            _cur += n;
+            if(_cur > _len) _len = _cur;
+            done += n;
+        }
+        return size;
+    }
+
+    // hand the current block over, wait until all blocks are written and flush the stream
+    // @return: false if any i/o failed
+    inline bool flush() {
+        publish();
+        wait_space(0);
+        if(!_failed.load()) {
+            _so.flush();   // the worker is idle now
+            if(_so.fail())
+                _failed = true;
+        }
+        return !_failed.load();
+    }
+
+    // true if any i/o failed, the later writes are dropped
+    inline bool fail() const {
+        return _failed.load();
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    // each block carries its position, so seeking never waits for the worker
+    inline size_t seek(pos_t pos) {
+        const auto end = tail();    // cannot move out size
+        if(pos < 0 || (size_t)pos > end)
+            pos = (pos_t)end;
+        return move_to((size_t)pos);
+    }
+
+    inline size_t offset(pos_t ofs) {
+        const auto end = tail();    // cannot move out size
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        else if((size_t)cur > end) cur = (pos_t)end;
+        return move_to((size_t)cur);
+    }
+private:
+    struct slot {
+        buffer_t buf;
+        size_t pos = 0;     // the position of the block begin
+        size_t len = 0;     // valid bytes
+    };
+
+    inline size_t tail() const {
+        return _pos + _len > _size ? _pos + _len : _size;
+    }
+
+    inline size_t move_to(size_t pos) {
+        if(pos >= _pos && pos <= _pos + _len) {
+            _cur = pos - _pos;
+            return pos;
+        }
+        publish();
+        _pos = pos;
+        return pos;
+    }
+
+    // push the current block to the queue, the next block begins at the current position
+    inline void publish() {
+        if(_len < 1)
+            return;
+        auto& sl = _slots[_t % _slots.size()];
+        sl.pos = _pos;
+        sl.len = _len;
+        _size = tail();
+        _pos += _cur;
+        _cur = _len = 0;
+        _tail.store(++_t);
+        count_transfer(*this);
+        if(_consumer_waiting.load()) {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _cv_data.notify_one();
+        }
+        wait_space(_slots.size() - 1);
+    }
+
+    // wait until at most n blocks are queued
+    inline void wait_space(size_t n) {
+        if(_t - _head.load() <= n)
+            return;
+        std::unique_lock<std::mutex> lock(_mtx);
+        _producer_waiting = true;
+        _cv_space.wait(lock,[&]{ return _t - _head.load() <= n; });
+        _producer_waiting = false;
+    }
+
+    inline void run() {
+        size_t at = 0;  // the stream position
+        for(;;) {
+            const auto h = _head.load(std::memory_order_relaxed);
+            if(h == _tail.load()) {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _consumer_waiting = true;
+                _cv_data.wait(lock,[&]{ return _stop || h != _tail.load(); });
+                _consumer_waiting = false;
+                if(h == _tail.load())
+                    return;     // stopped
+                continue;
+            }
+
+            auto& sl = _slots[h % _slots.size()];
+            if(!_failed.load(std::memory_order_relaxed)) {
+                if(sl.pos != at)
+                    _so.seekp(_beg + sl.pos,std::ios::beg);
+                _so.write((const char*)sl.buf.data(),sl.len);
+                if(_so.fail())
+                    _failed = true;
+                at = sl.pos + sl.len;
+            }
+            _head.store(h + 1);
+            if(_producer_waiting.load()) {
+                std::lock_guard<std::mutex> lock(_mtx);
+                _cv_space.notify_one();
+            }
+        }
+    }
+
+    std::ostream& _so;
+    const size_t _beg;      // the position of begin
+    size_t _size = 0;       // the stream size from begin, as far as handed over
+    std::vector<slot> _slots;
+    size_t _t = 0;          // the producer's copy of _tail, the slot being filled
+    size_t _pos = 0;        // the position of the block begin
+    size_t _cur = 0;        // current position in the block
+    size_t _len = 0;        // valid bytes in the block
+
+    std::atomic<size_t> _head{ 0 };     // the next slot to write, advanced by the worker
+    std::atomic<size_t> _tail{ 0 };     // the end of queued slots, advanced by the producer
+    std::atomic<bool> _failed{ false };
+    std::atomic<bool> _consumer_waiting{ false };
+    std::atomic<bool> _producer_waiting{ false };
+    bool _stop = false;
+    std::mutex _mtx;                    // only for sleeping
+    std::condition_variable _cv_data;
+    std::condition_variable _cv_space;
+    std::thread _worker;
+};
+
+// large writes are recorded as references to the caller memory, small ones are copied inline;
+// the referenced memory must stay alive and unchanged until the segments have been sent.
+// seek back and overwrite only works on inline bytes, e.g. for header back-patching
+template<typename I>
+struct basic_writer<Gather,I> : I
+{
+    basic_writer(const basic_writer&) = delete;
+    inline basic_writer(basic_writer&& o) :
+        _threshold(o._threshold),_inline(std::move(o._inline)),_segs(std::move(o._segs)),
+        _cur(o._cur),_size(o._size)
+    {
+        o._cur = o._size = 0;
+    }
+    // copy_threshold: writes at least so large are referenced instead of copied
+    inline explicit basic_writer(size_t copy_threshold = 256)
+        : _threshold(copy_threshold > 0 ? copy_threshold : 1)
+    {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        size_t done = 0;
+        if(_cur < _size) {
+            auto& sg = find(_cur);
+            if(sg.ext)
+                return 0;   // cannot overwrite the caller memory
+            const auto in_seg = sg.pos + sg.len - _cur;
+            if(size <= in_seg) {
+                memcpy(_inline.data() + sg.off + (_cur - sg.pos),buf,size);
+                _cur += size;
+                return size;
+            }
+            if(&sg != &_segs.back())
+                return 0;   // would run into the next segment
+            memcpy(_inline.data() + sg.off + (_cur - sg.pos),buf,in_seg);
+            _cur += in_seg;
+            done = in_seg;
+        }
+        append(buf + done,size - done);
+        return size;
+    }
+
+    inline void reserve(size_t capacity) {
+        _inline.reserve(capacity);
+    }
+
+    // the output as a list of segments, in order
+    inline std::vector<view_t> segments() const {
+        std::vector<view_t> out;
+        out.reserve(_segs.size());
+        for_each_segment([&](const uint8_t* data,size_t size){
+            out.push_back({ data,size });
+        });
+        return out;
+    }
+
+    // f(const uint8_t* data,size_t size) for each segment in order, e.g. to fill iovec/WSABUF
+    template<typename F>
+    inline void for_each_segment(F&& f) const {
+        for(auto& sg : _segs)
+            f(sg.ext ? sg.ext : _inline.data() + sg.off,sg.len);
+    }
+
+    inline size_t segment_count() const {
+        return _segs.size();
+    }
+
+    // the number of bytes have been written
+    inline size_t size() const {
+        return _size;
+    }
+
+    // drop all segments to start a new message, the inline capacity is kept
+    inline void clear() {
+        _inline.clear();
+        _segs.clear();
+        _cur = _size = 0;
+    }
+
+    inline size_t pos() const {
+        return _cur;
+    }
+
+    inline size_t seek(pos_t pos) {
+        _cur = _size;   // cannot move out size
+        if(pos >= 0 && (size_t)pos < _size)
+            _cur = (size_t)pos;
+        return this->pos();
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)_cur + ofs;
+        if(cur < 0) _cur = 0;
+        else if((size_t)cur > _size) _cur = _size;  // cannot move out size
+        else _cur = (size_t)cur;
+        return this->pos();
+    }
+private:
+    struct segment {
+        const uint8_t* ext;     // caller memory; nullptr if inline
+        size_t off;             // offset in _inline
+        size_t len;
+        size_t pos;             // the position of segment begin
+    };
+
+    inline void append(const uint8_t* buf,size_t size) {
+        if(size >= _threshold) {
+            _segs.push_back({ buf,0,size,_size });
+        } else {
+            const auto off = _inline.size();
+            _inline.resize(off + size);
+            memcpy(_inline.data() + off,buf,size);
+            if(!_segs.empty() && !_segs.back().ext)
+                _segs.back().len += size;   // the last inline segment always ends at the inline tail
+            else
+                _segs.push_back({ nullptr,off,size,_size });
+        }
+        _size += size;
+        _cur = _size;
+    }
+
+    // the segment which contains pos, pos < _size
+    inline segment& find(size_t pos) {
+        size_t lo = 0,hi = _segs.size();
+        while(hi - lo > 1) {
+            const auto mid = (lo + hi) / 2;
+            if(_segs[mid].pos <= pos) lo = mid;
+            else hi = mid;
+        }
+        return _segs[lo];
+    }
+
+    size_t _threshold;
+    raw_buffer_t _inline;       // the inline bytes of all inline segments
+    std::vector<segment> _segs;
+    size_t _cur = 0;
+    size_t _size = 0;
+};
+
+// sizeof(T) bytes reserved in a writer W, e.g. a length prefix known after the body:
+//     auto ph = w.placeholder<uint32_t>(); ...; ph.fill(uint32_t(w.pos() - start));
+// not filled, the reserved bytes stay zero
+template<typename W,typename T,Endian E>
+struct placeholder_t {
+    placeholder_t() = default;
+    placeholder_t(const placeholder_t&) = delete;
+    inline placeholder_t(placeholder_t&& o) : _w(o._w),_pos(o._pos) {
+        o._w = nullptr;
+    }
+    inline placeholder_t(W* w,size_t pos) : _w(w),_pos(pos) {}
+    inline ~placeholder_t() {
+        release();
+    }
+
+    // false if the bytes could not be reserved, or filled already
+    inline explicit operator bool() const {
+        return _w != nullptr;
+    }
+
+    // the position of the reserved bytes
+    inline size_t pos() const {
+        return _pos;
+    }
+
+    // write v in E byte order to the reserved bytes, the position of the writer is not moved
+    // @return: false if failed
+    inline bool fill(const T& v) {
+        if(!_w)
+            return false;
+        const T x = convert_endian<E>(v);
+        const auto ok = _w->patch(_pos,&x,sizeof(T));
+        release();
+        return ok;
+    }
+private:
+    inline void release() {
+        if(_w)
+            _w->unpin();
+        _w = nullptr;
+    }
+
+    W* _w = nullptr;
+    size_t _pos = 0;
+};
+
+// the typed api over a byte writer B: a basic_writer, or a filter such as lz4_writer
+template<typename B>
+struct typed_writer : public B {
+    using super = B;
+    using B::B;
+
+    // a short write sets the sticky fail flag, the later writes are dropped;
+    // a sequence can be checked once at its end
+    template<typename T>
+    inline size_t write(const T* const data, size_t size) {
+        const auto n = _failed ? 0 : super::write((uint8_t*)data,size);
+        if(n < size)
+            _failed = true;
+        return n;
+    }
+
+    // T with a schema follows its fields, see BIO_FIELDS; others are written as raw bytes
+    template<typename T>
+    inline size_t write(const T& data) {
+        if constexpr(has_schema<T>::value) {
+            return write_schema(*this,data);
+        } else {
+            // a literal "CKT" would be written with its NUL: write(data,size) says how many bytes
+            static_assert(!std::is_array<T>::value,"write(data,size) for arrays and string literals");
+            static_assert(!std::is_pointer<T>::value,"write(data,size) for the bytes a pointer points to");
+            static_assert(std::is_trivially_copyable<T>::value,"T must be trivially copyable");
+            return write(&data,sizeof(T));
+        }
+    }
+
+    // write a value in E byte order
+    template<Endian E,typename T>
+    inline size_t write(const T& data) {
+        const T v = convert_endian<E>(data);
+        return write(&v,sizeof(T));
+    }
+
+    template<typename T>
+    inline size_t write_le(const T& data) {
+        return write<LittleEndian>(data);
+    }
+
+    template<typename T>
+    inline size_t write_be(const T& data) {
+        return write<BigEndian>(data);
+    }
+
+    // write count elements in e byte order, foreign order is swapped through a stack block
+    // @return: the number of elements have been written
+    template<typename T>
+    inline size_t write_array(const T* data,size_t count,Endian e = NativeEndian) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,"T must be arithmetic or enum");
+        if(e == NativeEndian || sizeof(T) == 1)
+            return write(data,count * sizeof(T)) / sizeof(T);
+
+        constexpr size_t block = 4096 / sizeof(T);
+        T tmp[block];
+        size_t done = 0;
+        while(done < count) {
+            const auto n = count - done < block ? count - done : block;
+            memcpy(tmp,data + done,n * sizeof(T));
+            swap_bytes(tmp,n);
+            const auto w = write(tmp,n * sizeof(T)) / sizeof(T);
+            done += w;
+            if(w < n)
+                break;
+        }
+        return done;
+    }
+
+    // write a LEB128 varint, zigzag for signed T
+    // @return: the number of bytes written
+    template<typename T>
+    inline size_t write_varint(T v) {
+        uint8_t buf[varint_max_size<T>];
+        return write(buf,encode_varint(v,buf));
+    }
+
+    // @return: the number of bytes written, 0 if n does not fit the prefix
+    inline size_t write_length(size_t n,Prefix p = PrefixVarint) {
+        switch(p) {
+        case PrefixU8: return n <= UINT8_MAX ? write_le((uint8_t)n) : set_fail();
+        case PrefixU16: return n <= UINT16_MAX ? write_le((uint16_t)n) : set_fail();
+        case PrefixU32: return n <= UINT32_MAX ? write_le((uint32_t)n) : set_fail();
+        case PrefixU64: return write_le((uint64_t)n);
+        default: return write_varint(n);
+        }
+    }
+
+    // length prefixed strings and containers
+    // @return: the number of bytes written, 0 if failed
+    template<typename C,typename Tr>
+    inline size_t write(std::basic_string_view<C,Tr> str,Prefix p = PrefixVarint) {
+        const auto k = write_length(str.size(),p);
+        if(k < 1)
+            return 0;
+        const auto size = str.size() * sizeof(C);
+        return write(str.data(),size) == size ? k + size : 0;
+    }
+
+    template<typename C,typename Tr,typename A>
+    inline size_t write(const std::basic_string<C,Tr,A>& str,Prefix p = PrefixVarint) {
+        return write(std::basic_string_view<C,Tr>(str),p);
+    }
+
+    template<typename T,typename A>
+    inline size_t write(const std::vector<T,A>& vec,Prefix p = PrefixVarint) {
+        const auto k = write_length(vec.size(),p);
+        if(k < 1)
+            return 0;
+        if constexpr(is_bulk_element<T>) {
+            const auto size = vec.size() * sizeof(T);
+            return write(vec.data(),size) == size ? k + size : 0;
+        } else {
+            size_t total = k;
+            for(auto& e : vec) {
+                const auto m = write_item(e,p);
+                if(m < 1)
+                    return 0;
+                total += m;
+            }
+            return total;
+        }
+    }
+
+    template<typename K,typename V,typename C,typename A>
+    inline size_t write(const std::map<K,V,C,A>& map,Prefix p = PrefixVarint) {
+        return write_map(map,p);
+    }
+
+    template<typename K,typename V,typename H,typename E,typename A>
+    inline size_t write(const std::unordered_map<K,V,H,E,A>& map,Prefix p = PrefixVarint) {
+        return write_map(map,p);
+    }
+
+    // overwrite size written bytes at pos, the position is not moved; in memory if B can,
+    // by seeking back and forth otherwise. A failure does not set the fail flag
+    // @return: false if failed
+    template<typename T>
+    inline bool patch(size_t pos,const T* data,size_t size) {
+        if constexpr(has_patch<B>::value) {
+            return super::patch(pos,(const uint8_t*)data,size);
+        } else {
+            const auto at = super::pos();
+            if(super::seek((pos_t)pos) != pos)
+                return false;
+            const auto ok = super::write((const uint8_t*)data,size) == size;
+            super::seek((pos_t)at);
+            return ok;
+        }
+    }
+
+    // reserve sizeof(T) bytes at the current position, written later by fill() of the placeholder;
+    // the buffered stream keeps them in its block until then, so filling never seeks the stream
+    // @return: the placeholder, false if the bytes could not be written
+    template<typename T,Endian E = NativeEndian>
+    inline placeholder_t<typed_writer,T,E> placeholder() {
+        static_assert(std::is_trivially_copyable<T>::value,"T must be trivially copyable");
+        const auto at = super::pos();
+        const T zero{};
+        if(write(&zero,sizeof(T)) != sizeof(T))
+            return {};
+        pin();
+        return { this,at };
+    }
+
+    inline void pin() {
+        if constexpr(has_pin<B>::value)
+            super::pin();
+    }
+
+    inline void unpin() {
+        if constexpr(has_pin<B>::value)
+            super::unpin();
+    }
+
+    // true once a write was short or a length did not fit its prefix, or B reports a failure
+    inline bool fail() const {
+        if constexpr(has_fail<B>::value)
+            return _failed || super::fail();
+        else
+            return _failed;
+    }
+
+    inline bool good() const {
+        return !fail();
+    }
+
+    inline explicit operator bool() const {
+        return !fail();
+    }
+
+    inline void clear_fail() {
+        _failed = false;
+    }
+private:
+    inline size_t set_fail() {
+        _failed = true;
+        return 0;
+    }
+
+    template<typename T>
+    inline size_t write_item(const T& data,Prefix p) {
+        if constexpr(is_prefixed<T>::value) return write(data,p);
+        else return write(data);
+    }
+
+    template<typename M>
+    inline size_t write_map(const M& map,Prefix p) {
+        const auto k = write_length(map.size(),p);
+        if(k < 1)
+            return 0;
+        size_t total = k;
+        for(auto& kv : map) {
+            const auto a = write_item(kv.first,p);
+            const auto b = a > 0 ? write_item(kv.second,p) : 0;
+            if(b < 1)
+                return 0;
+            total += a + b;
+        }
+        return total;
+    }
+
+    bool _failed = false;
+};
+
+template<Mode MO,typename I = iwriter>
+struct writer : public typed_writer<counted_writer_t<basic_writer<MO,I>>> {
+    using typed_writer<counted_writer_t<basic_writer<MO,I>>>::typed_writer;
+};
+
+// writers without vtable, see direct
+template<Mode MO>
+using fast_writer = writer<MO,direct>;
+
+// type-erased adapter, for passing a fast_writer to code that needs iwriter
+template<typename W>
+struct iwriter_ref : iwriter {
+    inline iwriter_ref(W& w) : _w(w) {}
+
+    inline void reserve(size_t capacity) override { _w.reserve(capacity); }
+    inline size_t write(const uint8_t* buf,size_t size) override { return _w.write(buf,size); }
+    inline size_t pos() const override { return _w.pos(); }
+    inline size_t seek(pos_t pos) override { return _w.seek(pos); }
+    inline size_t offset(pos_t ofs) override { return _w.offset(ofs); }
+private:
+    W& _w;
+};
+
+// I = direct to make a fast_writer; out: any byte container, see is_byte_container.
+// writes past the end resize out, which zero-fills the new bytes before they are written
+// unless the container default-initializes, e.g. raw_buffer_t
+template<typename I = iwriter,typename C,typename = std::enable_if_t<is_byte_container<C>::value>>
+inline writer<Buffer,I> make_writer(C& out)
+{ return { out }; }
+
+template<typename I = iwriter>
+inline writer<Stream,I> make_writer(std::ostream& si)
+{ return { si }; }
+
+// the streambuf of so directly, see Streambuf
+template<typename I = iwriter>
+inline writer<Streambuf,I> make_streambuf_writer(std::ostream& so)
+{ return { so }; }
+
+template<typename I = iwriter>
+inline writer<AsyncStream,I> make_async_writer(std::ostream& so,size_t block_size = default_block_size,size_t depth = 4)
+{ return { so,block_size,depth }; }
+
+template<typename I = iwriter>
+inline writer<Gather,I> make_gather_writer(size_t copy_threshold = 256)
+{ return writer<Gather,I>{ copy_threshold }; }
+
+template<typename I = iwriter>
+inline writer<File,I> make_file_writer(const std::string& path,size_t block_size = default_block_size)
+{ return writer<File,I>{ path,block_size }; }
+
+template<typename I = iwriter>
+inline writer<BufferedStream,I> make_buffered_writer(std::ostream& so,size_t block_size = default_block_size)
+{ return { so,block_size }; }
+
+/////////////////////////////////////////////////////////////////////
+/// records: independent length prefixed records, decoded/encoded on several threads
+
+// encode a length prefix to out, which must have varint_max_size<uint64_t> bytes
+// @return: the number of bytes written, 0 if n does not fit the prefix
+inline size_t encode_length(size_t n,Prefix p,uint8_t* out) {
+    size_t k = 0;
+    switch(p) {
+    case PrefixU8: if(n > UINT8_MAX) return 0; k = 1; break;
+    case PrefixU16: if(n > UINT16_MAX) return 0; k = 2; break;
+    case PrefixU32: if(n > UINT32_MAX) return 0; k = 4; break;
+    case PrefixU64: k = 8; break;
+    default: return encode_varint((uint64_t)n,out);
+    }
+    for(size_t i = 0; i < k; ++i)
+        out[i] = (uint8_t)((uint64_t)n >> (i * 8));
+    return k;
+}
+
+// decode a length prefix from memory
+// @return: the number of bytes consumed, 0 if incomplete or out of size_t
+inline size_t decode_length(const uint8_t* data,size_t size,Prefix p,size_t& out) {
+    uint64_t v = 0;
+    size_t k = 0;
+    switch(p) {
+    case PrefixU8: k = 1; break;
+    case PrefixU16: k = 2; break;
+    case PrefixU32: k = 4; break;
+    case PrefixU64: k = 8; break;
+    default:
+        k = decode_varint(data,size,v);
+        if(k < 1)
+            return 0;
+        break;
+    }
+    if(p != PrefixVarint) {
+        if(size < k)
+            return 0;
+        for(size_t i = 0; i < k; ++i)
+            v |= (uint64_t)data[i] << (i * 8);
+    }
+    if(v > (uint64_t)SIZE_MAX)
+        return 0;
+    out = (size_t)v;
+    return k;
+}
+
+// index the records from the current position of an in-memory reader in one pass,
+// stops at the end or at a truncated record, prefix or payload, which is left unread;
+// the fail flag of r is not touched
+// @return: the payload of each record, sharing the memory of the source
+template<typename R>
+inline std::vector<view_t> index_records(R& r,Prefix p = PrefixVarint) {
+    static_assert(has_peek<R>::value,"only for in-memory modes");
+    std::vector<view_t> out;
+    for(;;) {
+        const auto head = r.peek(varint_max_size<uint64_t>);
+        size_t n;
+        const auto k = decode_length(head.data,head.size,p,n);
+        if(k < 1 || n > SIZE_MAX - k)
+            break;
+        const auto v = r.peek(k + n);
+        if(v.size != k + n)
+            break;
+        consume(r,k + n);
+        out.push_back({ v.data + k,n });
+    }
+    return out;
+}
+
+// threads - 1 workers kept across parallel loops, the calling thread of run() is the last one;
+// run() is not reentrant and is called by one thread at a time
+struct worker_pool {
+    worker_pool(const worker_pool&) = delete;
+    inline explicit worker_pool(size_t threads = 0) {
+        if(threads < 1) threads = std::thread::hardware_concurrency();
+        for(size_t i = 1; i < threads; ++i)
+            _workers.emplace_back([this]{ wait(); });
+    }
+    inline ~worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for(auto& t : _workers)
+            t.join();
+    }
+
+    inline size_t size() const {
+        return _workers.size() + 1;
+    }
+
+    // run f on [0,count), indices are claimed in batches, only by as many threads as batches;
+    // the first exception thrown by f is rethrown after all threads are done
+    template<typename F>
+    inline void run(size_t count,F&& f,size_t batch = 64) {
+        if(batch < 1) batch = 1;
+        auto helpers = (count + batch - 1) / batch;
+        helpers = helpers > 0 ? helpers - 1 : 0;
+        if(helpers > _workers.size()) helpers = _workers.size();
+
+        _next = 0;
+        _count = count;
+        _batch = batch;
+        _error = nullptr;
+        _f = (void*)&f;
+        _call = [](void* f,size_t i){ (*(std::remove_reference_t<F>*)f)(i); };
+        if(helpers > 0) {
+            {
+                std::lock_guard<std::mutex> lock(_mtx);
+                _helpers = _busy = helpers;
+                ++_round;
+            }
+            _wake.notify_all();
+        }
+        work();
+        if(helpers > 0) {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _done.wait(lock,[this]{ return _busy == 0; });
+        }
+        if(_error)
+            std::rethrow_exception(_error);
+    }
+private:
+    inline void work() {
+        try {
+            for(;;) {
+                const auto beg = _next.fetch_add(_batch);
+                if(beg >= _count)
+                    break;
+                const auto end = _count - beg < _batch ? _count : beg + _batch;
+                for(auto i = beg; i < end; ++i)
+                    _call(_f,i);
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(_error_mtx);
+            if(!_error) _error = std::current_exception();
+            _next = _count;
+        }
+    }
+
+    // a worker joins a round while it still needs helpers
+    inline void wait() {
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(_mtx);
+        for(;;) {
+            _wake.wait(lock,[&]{ return _stop || (_round != seen && _helpers > 0); });
+            if(_stop)
+                return;
+            seen = _round;
+            --_helpers;
+            lock.unlock();
+            work();
+            lock.lock();
+            if(--_busy == 0)
+                _done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> _workers;
+
+    // the current round, set by run() before the workers are woken
+    void* _f = nullptr;
+    void (*_call)(void* f,size_t i) = nullptr;
+    std::atomic<size_t> _next{ 0 };
+    size_t _count = 0;
+    size_t _batch = 1;
+    std::exception_ptr _error;
+    std::mutex _error_mtx;
+
+    // guarded by _mtx
+    size_t _round = 0;
+    size_t _helpers = 0;    // workers still to join the round
+    size_t _busy = 0;       // workers not done with the round
+    bool _stop = false;
+    std::mutex _mtx;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+};
+
+// run f on [0,count) with the calling thread and threads - 1 others, indices are claimed in batches;
+// the first exception thrown by f is rethrown after all threads are done.
+// The threads are started for this call, a worker_pool keeps them across calls
+template<typename F>
+inline void parallel_for(size_t count,F&& f,size_t threads = 0,size_t batch = 64) {
+    if(threads < 1) threads = std::thread::hardware_concurrency();
+    if(threads < 1) threads = 1;
+    if(batch < 1) batch = 1;
+    if(threads > (count + batch - 1) / batch) threads = (count + batch - 1) / batch;
+    if(threads <= 1) {
+        for(size_t i = 0; i < count; ++i)
+            f(i);
+        return;
+    }
+    worker_pool pool(threads);
+    pool.run(count,f,batch);
+}
+
+// decode the records in parallel, f(size_t index,fast_reader<Buffer>& r) with a reader over each payload
+template<typename F>
+inline void parallel_read_records(const std::vector<view_t>& records,F&& f,size_t threads = 0) {
+    parallel_for(records.size(),[&](size_t i){
+        fast_reader<Buffer> r(records[i].data,records[i].size);
+        f(i,r);
+    },threads);
+}
+
+// encode count records in parallel, f(size_t index,fast_writer<Buffer>& w) writes the payload of a record;
+// the framed records are appended to out in index order, window records at most are kept in memory.
+// The payloads are encoded straight into buffers reused across windows by the same threads,
+// the prefix is written to out ahead of each one
+// @return: the number of bytes have been written to out, less than expected if out failed
+// or a payload does not fit the prefix
+template<typename W,typename F>
+inline size_t parallel_write_records(W& out,size_t count,F&& f,Prefix p = PrefixVarint,
+                                     size_t threads = 0,size_t window = 4096) {
+    constexpr size_t batch = 64;
+    if(window < 1) window = 1;
+    const auto slots = count < window ? count : window;
+    if(threads < 1) threads = std::thread::hardware_concurrency();
+    if(threads > (slots + batch - 1) / batch) threads = (slots + batch - 1) / batch;
+    if(threads < 1) threads = 1;
+    worker_pool pool(threads);
+    std::vector<raw_buffer_t> payloads(slots);
+    size_t total = 0;
+    for(size_t beg = 0; beg < count; beg += window) {
+        const auto n = count - beg < window ? count - beg : window;
+        pool.run(n,[&](size_t i){
+            auto& payload = payloads[i];
+            payload.clear();
+            fast_writer<Buffer> w(payload);
+            f(beg + i,w);
+        },batch);
+        for(size_t i = 0; i < n; ++i) {
+            const auto& payload = payloads[i];
+            uint8_t head[varint_max_size<uint64_t>];
+            const auto k = encode_length(payload.size(),p,head);
+            if(k < 1)
+                return total;
+            auto m = out.write(head,k);
+            if(m == k)
+                m += out.write(payload.data(),payload.size());
+            total += m;
+            if(m != k + payload.size())
+                return total;
+        }
+    }
+    return total;
+}
+
+/////////////////////////////////////////////////////////////////////
+/// compression: block framed filters over any reader/writer
+//
+// frame: [u32le raw size][u32le stored size][stored bytes], stored size == raw size if the block
+// did not shrink and is kept as is; a frame of raw size 0 ends the compressed stream.
+// Frames are independent of each other, see parallel_decompress.
+//
+// codec: size_t bound(size_t n), the capacity compress needs for n bytes;
+// size_t compress(const uint8_t* in,size_t n,uint8_t* out,size_t capacity), 0 if failed;
+// bool decompress(const uint8_t* in,size_t n,uint8_t* out,size_t raw)
+
+constexpr size_t default_frame_size = 65536;
+
+// the largest raw frame, a corrupt header cannot allocate more
+constexpr size_t max_frame_size = (size_t)1 << 26;
+
+// no compression, only the framing
+struct store_codec {
+    inline size_t bound(size_t) const { return 0; }
+    inline size_t compress(const uint8_t*,size_t,uint8_t*,size_t) { return 0; }
+    inline bool decompress(const uint8_t*,size_t,uint8_t*,size_t) { return false; }
+};
+
+#ifdef BIO_HAS_LZ4
+struct lz4_codec {
+    inline size_t bound(size_t n) const {
+        return (size_t)LZ4_compressBound((int)n);
+    }
+    inline size_t compress(const uint8_t* in,size_t n,uint8_t* out,size_t capacity) {
+        const auto r = LZ4_compress_default((const char*)in,(char*)out,(int)n,(int)capacity);
+        return r > 0 ? (size_t)r : 0;
+    }
+    inline bool decompress(const uint8_t* in,size_t n,uint8_t* out,size_t raw) {
+        return LZ4_decompress_safe((const char*)in,(char*)out,(int)n,(int)raw) == (int)raw;
+    }
+};
+#endif
+
+#ifdef BIO_HAS_ZSTD
+// the contexts are created on first use and reused for every frame
+template<int Level = 3>
+struct zstd_codec {
+    zstd_codec() = default;
+    zstd_codec(const zstd_codec&) = delete;
+    inline ~zstd_codec() {
+        ZSTD_freeCCtx(_c);
+        ZSTD_freeDCtx(_d);
+    }
+
+    inline size_t bound(size_t n) const {
+        return ZSTD_compressBound(n);
+    }
+    inline size_t compress(const uint8_t* in,size_t n,uint8_t* out,size_t capacity) {
+        if(!_c && !(_c = ZSTD_createCCtx()))
+            return 0;
+        const auto r = ZSTD_compressCCtx(_c,out,capacity,in,n,Level);
+        return ZSTD_isError(r) ? 0 : r;
+    }
+    inline bool decompress(const uint8_t* in,size_t n,uint8_t* out,size_t raw) {
+        if(!_d && !(_d = ZSTD_createDCtx()))
+            return false;
+        const auto r = ZSTD_decompressDCtx(_d,out,raw,in,n);
+        return !ZSTD_isError(r) && r == raw;
+    }
+private:
+    ZSTD_CCtx* _c = nullptr;
+    ZSTD_DCtx* _d = nullptr;
+};
+#endif
+
+// decode the 8 bytes header of a frame, see above
+// @return: false for the end frame or a corrupt header
+inline bool decode_frame_header(const uint8_t* h,uint32_t& raw,uint32_t& stored) {
+    memcpy(&raw,h,4);
+    memcpy(&stored,h + 4,4);
+    raw = convert_endian<LittleEndian>(raw);
+    stored = convert_endian<LittleEndian>(stored);
+    return raw > 0 && raw <= max_frame_size && stored > 0 && stored <= raw;
+}
+
+// decompresses the frames of R on the fly; in-memory R are decoded without copy.
+// Seeking forward skips the frames without decoding them, back before the current block
+// restarts from the first frame if R can seek back
+template<typename R,typename C,typename I = direct>
+struct frame_reader : I {
+    frame_reader(const frame_reader&) = delete;
+    // the frames start at the current position of in, which must outlive the reader
+    inline frame_reader(R& in) : _in(in),_origin(in.pos()) {}
+
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        size_t done = 0;
+        for(;;) {
+            auto n = _len - _cur;
+            if(n > size - done)
+                n = size - done;
+            if(n > 0) {
+                memcpy(buf + done,_raw.data() + _cur,n);
+                _cur += n;
+                done += n;
+            }
+            uint32_t raw,stored;
+            if(done == size || !next(raw,stored))
+                return done;
+            if(size - done >= raw) {    // a whole frame: straight to buf
+                if(!decode(buf + done,raw,stored))
+                    return done;
+                _pos += raw;
+                done += raw;
+            } else if(!load(raw,stored)) {
+                return done;
+            }
+        }
+    }
+
+    inline size_t pos() const {
+        return _pos + _cur;
+    }
+
+    // pos < 0: to the end
+    inline size_t seek(pos_t pos) {
+        if(pos >= 0 && (size_t)pos < _pos)
+            rewind();
+        if(pos >= 0 && (size_t)pos < _pos)
+            return this->pos();     // cannot move back
+        if(pos >= 0 && (size_t)pos <= _pos + _len) {
+            _cur = (size_t)pos - _pos;
+            return this->pos();
+        }
+        return skip(pos < 0 ? unknown_size : (size_t)pos - this->pos());
+    }
+
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)pos() + ofs;
+        if(cur < 0) cur = 0;
+        return seek(cur);
+    }
+private:
+    // drop the current block and read the header of the next frame
+    inline bool next(uint32_t& raw,uint32_t& stored) {
+        _pos += _len;
+        _cur = _len = 0;
+        if(_end)
+            return false;
+        uint8_t h[8];
+        if(_in.read(h,sizeof(h)) != sizeof(h) || !decode_frame_header(h,raw,stored)) {
+            _end = true;
+            return false;
+        }
+        return true;
+    }
+
+    inline bool load(uint32_t raw,uint32_t stored) {
+        _raw.resize(raw);
+        if(!decode(_raw.data(),raw,stored))
+            return false;
+        _len = raw;
+        return true;
+    }
+
+    inline bool decode(uint8_t* out,uint32_t raw,uint32_t stored) {
+        bool ok;
+        if(stored == raw) {
+            ok = _in.read(out,raw) == raw;
+        } else if constexpr(has_peek<R>::value) {
+            const auto v = _in.view(stored);
+            ok = v.size == stored && _codec.decompress(v.data,stored,out,raw);
+        } else {
+            _comp.resize(stored);
+            ok = _in.read(_comp.data(),stored) == stored && _codec.decompress(_comp.data(),stored,out,raw);
+        }
+        if(!ok)
+            _end = true;
+        return ok;
+    }
+
+    inline size_t skip(size_t n) {
+        const auto avail = _len - _cur;
+        if(n <= avail) {
+            _cur += n;
+            return pos();
+        }
+        n -= avail;
+        _cur = _len;
+        uint32_t raw,stored;
+        while(n > 0 && next(raw,stored)) {
+            if(n < raw) {
+                if(load(raw,stored))
+                    _cur = n;
+                break;
+            }
+            const auto at = _in.pos();
+            if(_in.offset((pos_t)stored) != at + stored) {
+                _end = true;
+                break;
+            }
+            _pos += raw;
+            n -= raw;
+        }
+        return pos();
+    }
+
+    inline void rewind() {
+        if(_in.seek((pos_t)_origin) != _origin)
+            return;
+        _pos = _cur = _len = 0;
+        _end = false;
+    }
+
+    R& _in;
+    const size_t _origin;   // the position of the first frame in _in
+    C _codec;
+    raw_buffer_t _raw;      // the current block, decompressed
+    raw_buffer_t _comp;     // the stored bytes of a frame, if R is not in memory
+    size_t _pos = 0;        // the position of block begin
+    size_t _cur = 0;        // current position in the block
+    size_t _len = 0;        // valid bytes in the block
+    bool _end = false;      // the end frame is reached, or a frame is corrupt
+};
+
+// compresses to frames of frame_size raw bytes written to W; the end frame is written by finish()
+// or the destruction. Written frames cannot be changed: seek and offset only report the position
+template<typename W,typename C,typename I = direct>
+struct frame_writer : I {
+    frame_writer(const frame_writer&) = delete;
+    // out must outlive the writer
+    inline frame_writer(W& out,size_t frame_size = default_frame_size)
+        : _out(out),_frame(frame_size < 1 ? 1 : frame_size > max_frame_size ? max_frame_size : frame_size)
+    {}
+    inline ~frame_writer() {
+        finish();
+    }
+
+    inline void reserve(size_t) {}
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        if(!buf || size < 1 || _done)
+            return 0;
+        size_t done = 0;
+        if(!_raw.empty()) {     // complete the pending frame first
+            done = _frame - _raw.size() < size ? _frame - _raw.size() : size;
+            _raw.insert(_raw.end(),buf,buf + done);
+            if(_raw.size() < _frame)
+                return done;
+            if(!flush())
+                return 0;
+        }
+        while(size - done >= _frame) {  // whole frames straight from buf
+            if(!emit(buf + done,_frame))
+                return done;
+            _pos += _frame;
+            done += _frame;
+        }
+        if(done < size) {
+            if(_raw.capacity() < _frame)
+                _raw.reserve(_frame);
+            _raw.insert(_raw.end(),buf + done,buf + size);
+        }
+        return size;
+    }
+
+    inline size_t pos() const {
+        return _pos + _raw.size();
+    }
+
+    inline size_t seek(pos_t) {
+        return pos();
+    }
+
+    inline size_t offset(pos_t) {
+        return pos();
+    }
+
+    // write the pending bytes as a short frame
+    // @return: false if W failed
+    inline bool flush() {
+        if(_raw.empty())
+            return true;
+        const auto ok = emit(_raw.data(),_raw.size());
+        _pos += _raw.size();
+        _raw.clear();
+        return ok;
+    }
+
+    // flush and write the end frame, nothing can be written after
+    inline void finish() {
+        if(_done)
+            return;
+        flush();
+        const uint32_t end[2] = { 0,0 };
+        _out.write((const uint8_t*)end,sizeof(end));
+        _done = true;
+    }
+private:
+    inline bool emit(const uint8_t* data,size_t n) {
+        const auto bound = _codec.bound(n);
+        if(_comp.size() < 8 + bound)
+            _comp.resize(8 + bound);
+        auto stored = _codec.compress(data,n,_comp.data() + 8,bound);
+        if(stored < 1 || stored >= n)
+            stored = n;
+        const uint32_t h[2] = { convert_endian<LittleEndian>((uint32_t)n),
+                                convert_endian<LittleEndian>((uint32_t)stored) };
+        memcpy(_comp.data(),h,sizeof(h));
+        if(stored == n)
+            return _out.write(_comp.data(),8) == 8 && _out.write(data,n) == n;
+        return _out.write(_comp.data(),8 + stored) == 8 + stored;
+    }
+
+    W& _out;
+    const size_t _frame;    // raw bytes per frame
+    C _codec;
+    raw_buffer_t _raw;      // the pending frame
+    raw_buffer_t _comp;     // header and compressed frame
+    size_t _pos = 0;        // raw bytes in the written frames
+    bool _done = false;
+};
+
+template<typename R,typename C>
+using compressed_reader = typed_reader<frame_reader<R,C>>;
+
+template<typename W,typename C>
+using compressed_writer = typed_writer<frame_writer<W,C>>;
+
+#ifdef BIO_HAS_LZ4
+template<typename R>
+using lz4_reader = compressed_reader<R,lz4_codec>;
+
+template<typename W>
+using lz4_writer = compressed_writer<W,lz4_codec>;
+#endif
+
+#ifdef BIO_HAS_ZSTD
+template<typename R>
+using zstd_reader = compressed_reader<R,zstd_codec<>>;
+
+template<typename W,int Level = 3>
+using zstd_writer = compressed_writer<W,zstd_codec<Level>>;
+#endif
+
+// e.g. auto r = make_compressed_reader<lz4_codec>(inner);
+template<typename C,typename R>
+inline compressed_reader<R,C> make_compressed_reader(R& in)
+{ return { in }; }
+
+template<typename C,typename W>
+inline compressed_writer<W,C> make_compressed_writer(W& out,size_t frame_size = default_frame_size)
+{ return { out,frame_size }; }
+
+// a frame located in memory
+struct frame_t {
+    view_t stored;  // the stored bytes
+    size_t raw;     // the decompressed size
+};
+
+// index the frames from the current position of an in-memory reader,
+// the reader is left after the end frame, or at the first truncated or corrupt one
+// @return: true if the end frame is reached
+template<typename R>
+inline bool index_frames(R& r,std::vector<frame_t>& out) {
+    static_assert(has_peek<R>::value,"only for in-memory modes");
+    for(;;) {
+        const auto at = r.pos();
+        const auto h = r.view(8);
+        uint32_t raw,stored;
+        if(h.size != 8 || !decode_frame_header(h.data,raw,stored)) {
+            const auto end = h.size == 8 && raw == 0 && stored == 0;
+            if(!end)
+                r.seek((pos_t)at);
+            return end;
+        }
+        const auto v = r.view(stored);
+        if(v.size != stored) {
+            r.seek((pos_t)at);
+            return false;
+        }
+        out.push_back({ v,raw });
+    }
+}
+
+// decompress the frames from the current position of an in-memory reader on several threads,
+// appended to out; every thread has its own codec
+// @return: false if a frame is truncated or corrupt
+template<typename C,typename R,typename B>
+inline bool parallel_decompress(R& r,B& out,size_t threads = 0) {
+    std::vector<frame_t> frames;
+    if(!index_frames(r,frames))
+        return false;
+    std::vector<size_t> at(frames.size());
+    size_t total = out.size();
+    for(size_t i = 0; i < frames.size(); ++i) {
+        at[i] = total;
+        total += frames[i].raw;
+    }
+    out.resize(total);
+    std::atomic<bool> ok{ true };
+    parallel_for(frames.size(),[&](size_t i){
+        static thread_local C codec;
+        const auto& f = frames[i];
+        auto dst = (uint8_t*)&out[0] + at[i];
+        if(f.stored.size == f.raw)
+            memcpy(dst,f.stored.data,f.raw);
+        else if(!codec.decompress(f.stored.data,f.stored.size,dst,f.raw))
+            ok = false;
+    },threads,1);
+    return ok;
+}
+
+/////////////////////////////////////////////////////////////////////
+/// checksum: hash the bytes on their way through a reader/writer
+
+// 8 tables for slicing-by-8, t[0] is the bytewise table of the reflected polynomial 0x82f63b78
+struct crc32c_tables_t {
+    uint32_t t[8][256];
+};
+
+constexpr crc32c_tables_t make_crc32c_tables() {
+    crc32c_tables_t r{};
+    for(uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for(int k = 0; k < 8; ++k)
+            c = c & 1 ? (c >> 1) ^ 0x82f63b78u : c >> 1;
+        r.t[0][i] = c;
+    }
+    for(int k = 1; k < 8; ++k)
+        for(uint32_t i = 0; i < 256; ++i)
+            r.t[k][i] = (r.t[k - 1][i] >> 8) ^ r.t[0][r.t[k - 1][i] & 0xff];
+    return r;
+}
+
+inline constexpr crc32c_tables_t crc32c_tables = make_crc32c_tables();
+
+// the crc register state c after n bytes, slicing-by-8
+inline uint32_t crc32c_sw(const uint8_t* p,size_t n,uint32_t c) {
+    const auto& t = crc32c_tables.t;
+    for(; n >= 8; n -= 8,p += 8) {
+        uint64_t v;
+        memcpy(&v,p,8);
+        v = convert_endian<LittleEndian>(v) ^ c;
+        c = t[7][v & 0xff] ^ t[6][(v >> 8) & 0xff] ^ t[5][(v >> 16) & 0xff] ^ t[4][(v >> 24) & 0xff] ^
+            t[3][(v >> 32) & 0xff] ^ t[2][(v >> 40) & 0xff] ^ t[1][(v >> 48) & 0xff] ^ t[0][v >> 56];
+    }
+    for(; n > 0; --n)
+        c = t[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+    return c;
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__ARM_FEATURE_CRC32)
+// a * b modulo the polynomial, both reflected (bit 31 is x^0); a != 0
+constexpr uint32_t crc32c_multmodp(uint32_t a,uint32_t b) {
+    uint32_t m = 1u << 31,p = 0;
+    for(;;) {
+        if(a & m) {
+            p ^= b;
+            if((a & (m - 1)) == 0)
+                return p;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ 0x82f63b78u : b >> 1;
+    }
+}
+
+// stepping the register over L zero bytes, by the 4 bytes of the register
+struct crc32c_shift_t {
+    uint32_t t[4][256];
+};
+
+constexpr crc32c_shift_t make_crc32c_shift(size_t L) {
+    uint32_t k = 1u << 31,x = 1u << 30;    // x^(8L) by squaring x
+    for(size_t e = 8 * L; e > 0; e >>= 1,x = crc32c_multmodp(x,x))
+        if(e & 1) k = crc32c_multmodp(k,x);
+    crc32c_shift_t r{};
+    for(int i = 0; i < 4; ++i)
+        for(uint32_t b = 0; b < 256; ++b)
+            r.t[i][b] = crc32c_multmodp(k,b << (8 * i));
+    return r;
+}
+
+// the crc instructions take 3 cycles and issue 1 per cycle, so 3 independent streams over
+// stripes of L bytes keep the unit busy; crc32c_long for large inputs, crc32c_short for the rest
+constexpr size_t crc32c_long = 8192;
+constexpr size_t crc32c_short = 256;
+template<size_t L>
+inline constexpr crc32c_shift_t crc32c_shift = make_crc32c_shift(L);
+
+template<size_t L>
+inline uint32_t crc32c_shifted(uint32_t c) {
+    const auto& t = crc32c_shift<L>.t;
+    return t[0][c & 0xff] ^ t[1][(c >> 8) & 0xff] ^ t[2][(c >> 16) & 0xff] ^ t[3][c >> 24];
+}
+#endif
+
+#if (defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))) || defined(BIO_CRC32C_DISPATCH)
+template<size_t L>
+BIO_TARGET_SSE42 inline uint32_t crc32c_sse42_3way(const uint8_t*& p,size_t& n,uint32_t c) {
+    for(; n >= 3 * L; n -= 3 * L,p += 3 * L) {
+        uint64_t c0 = c,c1 = 0,c2 = 0;
+        for(size_t i = 0; i < L; i += 8) {
+            uint64_t v0,v1,v2;
+            memcpy(&v0,p + i,8);
+            memcpy(&v1,p + L + i,8);
+            memcpy(&v2,p + 2 * L + i,8);
+            c0 = _mm_crc32_u64(c0,v0);
+            c1 = _mm_crc32_u64(c1,v1);
+            c2 = _mm_crc32_u64(c2,v2);
+        }
+        c = crc32c_shifted<L>(crc32c_shifted<L>((uint32_t)c0) ^ (uint32_t)c1) ^ (uint32_t)c2;
+    }
+    return c;
+}
+
+BIO_TARGET_SSE42 inline uint32_t crc32c_sse42(const uint8_t* p,size_t n,uint32_t c) {
+    c = crc32c_sse42_3way<crc32c_long>(p,n,c);
+    c = crc32c_sse42_3way<crc32c_short>(p,n,c);
+    uint64_t c64 = c;
+    for(; n >= 8; n -= 8,p += 8) {
+        uint64_t v;
+        memcpy(&v,p,8);
+        c64 = _mm_crc32_u64(c64,v);
+    }
+    c = (uint32_t)c64;
+    for(; n > 0; --n)
+        c = _mm_crc32_u8(c,*p++);
+    return c;
+}
+#endif
+
+#if defined(BIO_CRC32C_DISPATCH)
+inline bool crc32c_has_sse42() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info,1);
+    return (info[2] >> 20) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+
+// CRC32C (Castagnoli) of n bytes, continued from the crc of the previous bytes;
+// on x86-64 the SSE4.2 crc32 instruction in 3 interleaved streams, selected at runtime unless
+// the build enables SSE4.2 (e.g. -msse4.2 or -march=native) so that no check is needed;
+// the ARMv8 crc instructions if enabled, e.g. -march=armv8-a+crc; slicing-by-8 otherwise
+inline uint32_t crc32c(const void* data,size_t n,uint32_t crc = 0) {
+    auto p = (const uint8_t*)data;
+    uint32_t c = ~crc;
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+    c = crc32c_sse42(p,n,c);
+#elif defined(BIO_CRC32C_DISPATCH)
+    static const bool hw = crc32c_has_sse42();
+    c = hw ? crc32c_sse42(p,n,c) : crc32c_sw(p,n,c);
+#elif defined(__ARM_FEATURE_CRC32)
+    for(; n >= 3 * crc32c_long; n -= 3 * crc32c_long,p += 3 * crc32c_long) {
+        constexpr auto L = crc32c_long;
+        uint32_t c0 = c,c1 = 0,c2 = 0;
+        for(size_t i = 0; i < L; i += 8) {
+            uint64_t v0,v1,v2;
+            memcpy(&v0,p + i,8);
+            memcpy(&v1,p + L + i,8);
+            memcpy(&v2,p + 2 * L + i,8);
+            c0 = __crc32cd(c0,v0);
+            c1 = __crc32cd(c1,v1);
+            c2 = __crc32cd(c2,v2);
+        }
+        c = crc32c_shifted<L>(crc32c_shifted<L>(c0) ^ c1) ^ c2;
+    }
+    for(; n >= 8; n -= 8,p += 8) {
+        uint64_t v;
+        memcpy(&v,p,8);
+        c = __crc32cd(c,v);
+    }
+    for(; n > 0; --n)
+        c = __crc32cb(c,*p++);
+#else
+    c = crc32c_sw(p,n,c);
+#endif
+    return ~c;
+}
+
+// hash: void update(const uint8_t* p,size_t n), digest() of the bytes so far, reset()
+struct crc32c_hash {
+    inline void update(const uint8_t* p,size_t n) { _crc = crc32c(p,n,_crc); }
+    inline uint32_t digest() const { return _crc; }
+    inline void reset() { _crc = 0; }
+private:
+    uint32_t _crc = 0;
+};
+
+// hashes every byte read from R; the digest covers [begin,pos()) from the construction,
+// so seeking forward reads through the skipped bytes and seeking back is not possible
+template<typename R,typename H = crc32c_hash,typename I = direct>
+struct hash_reader : I {
+    hash_reader(const hash_reader&) = delete;
+    // in must outlive the reader
+    inline hash_reader(R& in) : _in(in),_begin(in.pos()) {}
+
+    inline size_t read(uint8_t* buf,size_t size) {
+        const auto n = _in.read(buf,size);
+        if(n > 0)
+            _hash.update(buf,n);
+        return n;
+    }
+
+    inline size_t pos() const {
+        return _in.pos() - _begin;
+    }
+
+    // pos < 0: to the end
+    inline size_t seek(pos_t pos) {
+        uint8_t buf[4096];
+        auto n = pos < 0 ? unknown_size : (size_t)pos > this->pos() ? (size_t)pos - this->pos() : 0;
+        while(n > 0) {
+            const auto m = read(buf,n < sizeof(buf) ? n : sizeof(buf));
+            if(m < 1)
+                break;
+            n -= m;
+        }
+        return this->pos();
+    }
+
+    inline size_t offset(pos_t ofs) {
+        return ofs > 0 ? seek((pos_t)pos() + ofs) : pos();
+    }
+
+    // the digest of the bytes read so far
+    inline auto digest() const {
+        return _hash.digest();
+    }
+
+    inline H& hash() {
+        return _hash;
+    }
+private:
+    R& _in;
+    const size_t _begin;    // the position of begin in _in
+    H _hash;
+};
+
+// hashes every byte written to W; written bytes cannot be changed: seek and offset only report the position
+template<typename W,typename H = crc32c_hash,typename I = direct>
+struct hash_writer : I {
+    hash_writer(const hash_writer&) = delete;
+    // out must outlive the writer
+    inline hash_writer(W& out) : _out(out),_begin(out.pos()) {}
+
+    inline void reserve(size_t capacity) {
+        _out.reserve(capacity);
+    }
+
+    inline size_t write(const uint8_t* buf,size_t size) {
+        const auto n = _out.write(buf,size);
+        if(n > 0)
+            _hash.update(buf,n);
+        return n;
+    }
+
+    inline size_t pos() const {
+        return _out.pos() - _begin;
+    }
+
+    inline size_t seek(pos_t) {
+        return pos();
+    }
+
+    inline size_t offset(pos_t) {
+        return pos();
+    }
+
+    // the digest of the bytes written so far
+    inline auto digest() const {
+        return _hash.digest();
+    }
+
+    inline H& hash() {
+        return _hash;
+    }
+private:
+    W& _out;
+    const size_t _begin;    // the position of begin in _out
+    H _hash;
+};
+
+template<typename R,typename H = crc32c_hash>
+using checksum_reader = typed_reader<hash_reader<R,H>>;
+
+template<typename W,typename H = crc32c_hash>
+using checksum_writer = typed_writer<hash_writer<W,H>>;
+
+template<typename H = crc32c_hash,typename R>
+inline checksum_reader<R,H> make_checksum_reader(R& in)
+{ return { in }; }
+
+template<typename H = crc32c_hash,typename W>
+inline checksum_writer<W,H> make_checksum_writer(W& out)
+{ return { out }; }
+
+/////////////////////////////////////////////////////////////////////
+/// pack: many blobs in one file, located by key through a sorted table of contents
+//
+// [blob]...[toc][footer]
+// toc: count entries of [u64le offset][u64le size][u32le key offset][u32le key size] sorted by key
+//      bytewise, then the keys; offsets are from the pack begin, key offsets from the end of entries
+// footer: [u64le toc offset][u64le toc size][u32le count][u32le crc32c of toc][u64le pack_magic]
+
+constexpr uint64_t pack_magic = 0x314b4341504f4942ull;   // "BIOPACK1"
+constexpr size_t pack_footer_size = 32;
+constexpr size_t pack_entry_size = 24;
+
+struct pack_entry {
+    uint64_t offset = 0;    // from the pack begin
+    uint64_t size = 0;
+};
+
+struct pack_footer {
+    uint64_t toc_offset = 0;
+    uint64_t toc_size = 0;
+    uint32_t count = 0;
+    uint32_t crc = 0;
+};
+
+template<typename T>
+inline T load_le(const uint8_t* p) {
+    T v;
+    memcpy(&v,p,sizeof(T));
+    return convert_endian<LittleEndian>(v);
+}
+
+// the footer at the end of a pack of pack_size bytes
+// @return: false if it is no pack footer or does not fit the pack
+inline bool decode_pack_footer(const uint8_t* p,size_t pack_size,pack_footer& out) {
+    if(pack_size < pack_footer_size || load_le<uint64_t>(p + 24) != pack_magic)
+        return false;
+    out.toc_offset = load_le<uint64_t>(p);
+    out.toc_size = load_le<uint64_t>(p + 8);
+    out.count = load_le<uint32_t>(p + 16);
+    out.crc = load_le<uint32_t>(p + 20);
+    const auto room = pack_size - pack_footer_size;
+    return out.toc_offset <= room && out.toc_size == room - out.toc_offset &&
+           (uint64_t)out.count * pack_entry_size <= out.toc_size;
+}
+
+// appends blobs to a writer W, then the toc and the footer by finish() or destruction;
+// the pack begins at the position of W at construction
+template<typename W>
+struct pack_writer {
+    pack_writer(const pack_writer&) = delete;
+    inline pack_writer(W& out) : _w(out),_beg(out.pos()) {}
+    inline ~pack_writer() {
+        finish();
+    }
+
+    // a key added again replaces the blob of the earlier one, whose bytes stay in the pack
+    // @return: false if the writer failed or the pack is finished
+    inline bool add(std::string_view key,const void* data,size_t size) {
+        return add(key,[&](W& w){ w.write((const uint8_t*)data,size); });
+    }
+
+    // f(W& w) writes the blob
+    template<typename F>
+    inline bool add(std::string_view key,F&& f) {
+        if(_done || key.size() > UINT32_MAX)
+            return false;
+        const auto at = _w.pos();
+        f(_w);
+        if(_w.fail())
+            return false;
+        _entries.push_back({ std::string(key),{ at - _beg,_w.pos() - at } });
+        return true;
+    }
+
+    inline size_t size() const {
+        return _entries.size();
+    }
+
+    // write the toc and the footer, nothing can be added after
+    // @return: false if the writer failed or the toc is too large
+    inline bool finish() {
+        if(_done)
+            return !_w.fail();
+        _done = true;
+        std::stable_sort(_entries.begin(),_entries.end(),[](const entry& a,const entry& b){
+            return a.key < b.key;
+        });
+        size_t n = 0;   // the last of equal keys is kept
+        for(size_t i = 0; i < _entries.size(); ++i) {
+            if(i + 1 < _entries.size() && _entries[i + 1].key == _entries[i].key)
+                continue;
+            if(n != i)
+                _entries[n] = std::move(_entries[i]);
+            ++n;
+        }
+        _entries.resize(n);
+        if(n > UINT32_MAX)
+            return false;
+
+        raw_buffer_t toc;
+        {
+            fast_writer<Buffer> w(toc);
+            uint64_t keys = 0;
+            for(auto& e : _entries) {
+                if(keys + e.key.size() > UINT32_MAX)
+                    return false;
+                w.write_le(e.at.offset);
+                w.write_le(e.at.size);
+                w.write_le((uint32_t)keys);
+                w.write_le((uint32_t)e.key.size());
+                keys += e.key.size();
+            }
+            for(auto& e : _entries)
+                w.write((const uint8_t*)e.key.data(),e.key.size());
+        }
+        const uint64_t toc_offset = _w.pos() - _beg;
+        _w.write(toc.data(),toc.size());
+        _w.write_le(toc_offset);
+        _w.write_le((uint64_t)toc.size());
+        _w.write_le((uint32_t)n);
+        _w.write_le(crc32c(toc.data(),toc.size()));
+        _w.write_le(pack_magic);
+        return !_w.fail();
+    }
+private:
+    struct entry {
+        std::string key;
+        pack_entry at;
+    };
+
+    W& _w;
+    const size_t _beg;
+    std::vector<entry> _entries;
+    bool _done = false;
+};
+
+// the toc of a pack in memory, looked up by binary search without parsing it first
+struct pack_index {
+    pack_index() = default;
+    inline pack_index(const uint8_t* toc,const pack_footer& f)
+        : _toc(toc),_size(f.toc_size),_count(f.count),_crc(f.crc)
+    {}
+
+    inline size_t size() const {
+        return _count;
+    }
+
+    // the key of the i-th entry in key order, i < size(); empty if the entry points out of the toc
+    inline std::string_view key(size_t i) const {
+        const auto p = _toc + i * pack_entry_size;
+        const auto pool = (size_t)_count * pack_entry_size;
+        const size_t off = load_le<uint32_t>(p + 16);
+        const size_t n = load_le<uint32_t>(p + 20);
+        if(off > _size - pool || n > _size - pool - off)
+            return {};
+        return { (const char*)_toc + pool + off,n };
+    }
+
+    inline pack_entry entry(size_t i) const {
+        const auto p = _toc + i * pack_entry_size;
+        return { load_le<uint64_t>(p),load_le<uint64_t>(p + 8) };
+    }
+
+    // @return: false if key is not in the pack
+    inline bool find(std::string_view key,pack_entry& out) const {
+        size_t lo = 0,hi = _count;
+        while(lo < hi) {
+            const auto mid = lo + (hi - lo) / 2;
+            const auto c = this->key(mid).compare(key);
+            if(c == 0) {
+                out = entry(mid);
+                return true;
+            }
+            if(c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return false;
+    }
+
+    // check the crc of the toc, which touches all of it
+    inline bool verify() const {
+        return _toc && crc32c(_toc,_size) == _crc;
+    }
+private:
+    const uint8_t* _toc = nullptr;
+    size_t _size = 0;
+    uint32_t _count = 0;
+    uint32_t _crc = 0;
+};
+
+// a pack in memory: only the footer, the visited toc entries and the blobs opened are touched,
+// so a lookup into a mapped pack costs a few page faults
+struct pack_view {
+    pack_view() = default;
+    inline pack_view(const uint8_t* data,size_t size) {
+        pack_footer f;
+        if(data && size >= pack_footer_size && decode_pack_footer(data + size - pack_footer_size,size,f)) {
+            _data = data;
+            _size = size;
+            _index = { data + f.toc_offset,f };
+        }
+    }
+
+    // false if no pack
+    inline bool is_open() const {
+        return _data != nullptr;
+    }
+
+    inline const pack_index& index() const {
+        return _index;
+    }
+
+    // @return: false if key is not in the pack or its blob is out of the pack
+    inline bool find(std::string_view key,pack_entry& out) const {
+        return _index.find(key,out) && out.offset <= _size && out.size <= _size - out.offset;
+    }
+
+    // the blob of key, empty if not found
+    inline view_t view(std::string_view key) const {
+        pack_entry e;
+        if(!find(key,e))
+            return {};
+        return { _data + e.offset,(size_t)e.size };
+    }
+
+    // a reader over the blob of key, empty if not found
+    template<typename I = direct>
+    inline reader<Buffer,I> open(std::string_view key) const {
+        const auto v = view(key);
+        return { v.data,v.size };
+    }
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    pack_index _index;
+};
+
+// a pack file mapped in memory
+struct mapped_pack : private mapped_file, public pack_view {
+    mapped_pack(const mapped_pack&) = delete;
+    inline explicit mapped_pack(const std::string& path)
+        : mapped_file(path),pack_view(mapped_file::data(),mapped_file::size())
+    {}
+
+    using pack_view::is_open;
+    using pack_view::open;
+};
+
+// a pack file read through positional i/o: the footer and the toc are loaded at open,
+// blobs are read by reader<File> windows, so it is searched and read from several threads
+struct file_pack {
+    file_pack(const file_pack&) = delete;
+    // flags: file_random, file_sequential
+    inline explicit file_pack(const std::string& path,unsigned flags = file_random)
+        : _own(path,flags & ~(file_write | file_direct)),_fh(&_own)
+    {
+        load();
+    }
+    // a shared handle not opened with file_direct, which must outlive this
+    inline explicit file_pack(const raw_file& fh)
+        : _fh(&fh)
+    {
+        load();
+    }
+
+    // false if the file cannot be opened or is no pack
+    inline bool is_open() const {
+        return _size > 0;
+    }
+
+    inline const pack_index& index() const {
+        return _index;
+    }
+
+    // @return: false if key is not in the pack or its blob is out of the pack
+    inline bool find(std::string_view key,pack_entry& out) const {
+        return _index.find(key,out) && out.offset <= _size && out.size <= _size - out.offset;
+    }
+
+    // a reader over the blob of key with its own block and position, empty if not found
+    template<typename I = direct>
+    inline reader<File,I> open(std::string_view key,size_t block_size = default_block_size) const {
+        pack_entry e;
+        if(!find(key,e))
+            e = {};
+        return { *_fh,(size_t)e.offset,(size_t)e.size,block_size };
+    }
+
+    // read the whole blob of key into out
+    // @return: false if not found or the read was short
+    template<typename C>
+    inline bool read(std::string_view key,C& out) const {
+        pack_entry e;
+        if(!find(key,e))
+            return false;
+        out.resize((size_t)e.size);
+        return _fh->read_at(out.data(),(size_t)e.size,(size_t)e.offset) == e.size;
+    }
+
+    inline const raw_file& file() const {
+        return *_fh;
+    }
+private:
+    inline void load() {
+        const auto size = _fh->size();
+        uint8_t tail[pack_footer_size];
+        pack_footer f;
+        if(size < pack_footer_size ||
+           _fh->read_at(tail,pack_footer_size,size - pack_footer_size) != pack_footer_size ||
+           !decode_pack_footer(tail,size,f))
+            return;
+        _toc.resize((size_t)f.toc_size);
+        if(_fh->read_at(_toc.data(),_toc.size(),(size_t)f.toc_offset) != _toc.size())
+            return;
+        _index = { _toc.data(),f };
+        _size = size;
+    }
+
+    raw_file _own;          // closed if the handle is shared
+    const raw_file* _fh;
+    size_t _size = 0;
+    buffer_t _toc;
+    pack_index _index;
+};
+
+/////////////////////////////////////////////////////////////////////
+/// batch: many small positional reads of a raw_file in one submission
+
+struct read_request {
+    size_t offset = 0;      // in the file
+    size_t size = 0;
+    void* data = nullptr;   // size bytes of destination
+    size_t result = 0;      // bytes read, short at the end of file or on an error
+};
+
+// submits the reads through one io_uring where the kernel allows it, with pread/ReadFile one by one
+// otherwise or for the reads the ring refused; the ring is set up once, so keep one per thread
+struct batch_reader {
+    batch_reader(const batch_reader&) = delete;
+    // depth: the reads in flight at most
+    inline explicit batch_reader(unsigned depth = 64) {
+#ifdef BIO_HAS_URING
+        setup(depth > 0 ? depth : 1);
+#else
+        (void)depth;
+#endif
+    }
+    inline ~batch_reader() {
+#ifdef BIO_HAS_URING
+        teardown();
+#endif
+    }
+
+    // true if the reads go through io_uring
+    inline bool uring() const {
+#ifdef BIO_HAS_URING
+        return _ring >= 0;
+#else
+        return false;
+#endif
+    }
+
+    // read n requests of fh, f(read_request&) on each as it completes, in completion order
+    // @return: the number of requests read in full
+    template<typename F>
+    inline size_t read(const raw_file& fh,read_request* reqs,size_t n,F&& f) {
+#ifdef BIO_HAS_URING
+        if(_ring >= 0)
+            return read_ring(fh,reqs,n,f);
+#endif
+        size_t ok = 0;
+        for(size_t i = 0; i < n; ++i) {
+            reqs[i].result = 0;
+            ok += complete(fh,reqs[i]);
+            f(reqs[i]);
+        }
+        return ok;
+    }
+
+    inline size_t read(const raw_file& fh,read_request* reqs,size_t n) {
+        return read(fh,reqs,n,[](read_request&){});
+    }
+
+    inline size_t read(const raw_file& fh,std::vector<read_request>& reqs) {
+        return read(fh,reqs.data(),reqs.size());
+    }
+private:
+    // read the rest of r synchronously
+    // @return: 1 if r is read in full
+    static inline size_t complete(const raw_file& fh,read_request& r) {
+        if(r.result < r.size)
+            r.result += fh.read_at((uint8_t*)r.data + r.result,r.size - r.result,r.offset + r.result);
+        return r.result == r.size ? 1 : 0;
+    }
+
+#ifdef BIO_HAS_URING
+    template<typename F>
+    inline size_t read_ring(const raw_file& fh,read_request* reqs,size_t n,F& f) {
+        size_t next = 0,ok = 0;
+        unsigned inflight = 0,unsubmitted = 0;
+        while(next < n || inflight > 0) {
+            auto tail = *_sq_tail;
+            while(next < n && inflight < _entries) {
+                auto& r = reqs[next];
+                r.result = 0;
+                if(r.size < 1) {
+                    ++ok;
+                    f(r);
+                    ++next;
+                    continue;
+                }
+                const auto idx = tail & *_sq_mask;
+                auto& sqe = _sqes[idx];
+                memset(&sqe,0,sizeof(sqe));
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fh.native();
+                sqe.addr = (uint64_t)(uintptr_t)r.data;
+                sqe.len = r.size < 0x7ffff000 ? (unsigned)r.size : 0x7ffff000u;
+                sqe.off = r.offset;
+                sqe.user_data = next;
+                _sq_array[idx] = idx;
+                ++tail;
+                ++inflight;
+                ++unsubmitted;
+                ++next;
+            }
+            __atomic_store_n(_sq_tail,tail,__ATOMIC_RELEASE);
+            if(inflight < 1)
+                break;
+
+            // submit and wait for one completion at least
+            const auto rc = syscall(__NR_io_uring_enter,_ring,unsubmitted,1,IORING_ENTER_GETEVENTS,nullptr,0);
+            if(rc >= 0) {
+                unsubmitted -= (unsigned)rc;
+            } else if(errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                // not consumed by the kernel: take them back and read them here
+                auto t = *_sq_tail;
+                for(; unsubmitted > 0; --unsubmitted,--inflight) {
+                    --t;
+                    auto& r = reqs[_sqes[_sq_array[t & *_sq_mask]].user_data];
+                    ok += complete(fh,r);
+                    f(r);
+                }
+                __atomic_store_n(_sq_tail,t,__ATOMIC_RELEASE);
+                std::this_thread::yield();  // the submitted ones are polled
+            }
+
+            auto head = *_cq_head;
+            const auto end = __atomic_load_n(_cq_tail,__ATOMIC_ACQUIRE);
+            for(; head != end; ++head) {
+                const auto& cqe = _cqes[head & *_cq_mask];
+                auto& r = reqs[cqe.user_data];
+                if(cqe.res > 0)
+                    r.result = (size_t)cqe.res;
+                // refused by the ring (e.g. IORING_OP_READ before linux 5.6) or short: read the rest here
+                if(cqe.res < 0 || (cqe.res > 0 && r.result < r.size))
+                    ok += complete(fh,r);
+                else
+                    ok += r.result == r.size ? 1 : 0;
+                --inflight;
+                f(r);
+            }
+            __atomic_store_n(_cq_head,head,__ATOMIC_RELEASE);
+        }
+        return ok;
+    }
+
+    inline void setup(unsigned depth) {
+        io_uring_params p;
+        memset(&p,0,sizeof(p));
+        const auto fd = syscall(__NR_io_uring_setup,depth,&p);
+        if(fd < 0)
+            return;     // e.g. disabled by seccomp or sysctl
+        _ring = (int)fd;
+        _entries = p.sq_entries;
+        _sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        _cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single)
+            _sq_len = _cq_len = _sq_len > _cq_len ? _sq_len : _cq_len;
+        _sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+
+        _sq = mmap(nullptr,_sq_len,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,_ring,IORING_OFF_SQ_RING);
+        _cq = single ? _sq :
+              mmap(nullptr,_cq_len,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,_ring,IORING_OFF_CQ_RING);
+        auto sqes = mmap(nullptr,_sqes_len,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,_ring,IORING_OFF_SQES);
+        _sqes = sqes == MAP_FAILED ? nullptr : (io_uring_sqe*)sqes;
+        if(_sq == MAP_FAILED) _sq = nullptr;
+        if(_cq == MAP_FAILED) _cq = nullptr;
+        if(!_sq || !_cq || !_sqes) {
+            teardown();
+            return;
+        }
+        auto sq = (uint8_t*)_sq;
+        auto cq = (uint8_t*)_cq;
+        _sq_tail = (unsigned*)(sq + p.sq_off.tail);
+        _sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+        _sq_array = (unsigned*)(sq + p.sq_off.array);
+        _cq_head = (unsigned*)(cq + p.cq_off.head);
+        _cq_tail = (unsigned*)(cq + p.cq_off.tail);
+        _cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+        _cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    }
+
+    inline void teardown() {
+        if(_sqes) munmap(_sqes,_sqes_len);
+        if(_cq && _cq != _sq) munmap(_cq,_cq_len);
+        if(_sq) munmap(_sq,_sq_len);
+        if(_ring >= 0) ::close(_ring);
+        _sqes = nullptr;
+        _sq = _cq = nullptr;
+        _ring = -1;
+    }
+
+    int _ring = -1;
+    unsigned _entries = 0;
+    void* _sq = nullptr;
+    void* _cq = nullptr;
+    size_t _sq_len = 0,_cq_len = 0,_sqes_len = 0;
+    io_uring_sqe* _sqes = nullptr;
+    unsigned* _sq_tail = nullptr;
+    unsigned* _sq_mask = nullptr;
+    unsigned* _sq_array = nullptr;
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned* _cq_mask = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+#endif
+};
+
+// read the blobs of keys from a pack in one batch, out[i] is resized to the blob of keys[i]
+// and cleared if keys[i] is not in the pack
+// @return: the number of blobs read in full
+template<typename C>
+inline size_t read_blobs(batch_reader& br,const file_pack& pk,const std::vector<std::string_view>& keys,
+                         std::vector<C>& out) {
+    out.resize(keys.size());
+    std::vector<read_request> reqs;
+    reqs.reserve(keys.size());
+    for(size_t i = 0; i < keys.size(); ++i) {
+        pack_entry e;
+        if(!pk.find(keys[i],e)) {
+            out[i].clear();
+            continue;
+        }
+        out[i].resize((size_t)e.size);
+        read_request r;
+        r.offset = (size_t)e.offset;
+        r.size = (size_t)e.size;
+        r.data = out[i].data();
+        reqs.push_back(r);
+    }
+    return br.read(pk.file(),reqs);
+}
+
+/////////////////////////////////////////////////////////////////////
+/// source: immutable shared bytes, read by trivially copyable cursors on any thread
+
+struct basic_cursor;
+using cursor = typed_reader<basic_cursor>;
+
+// reference counted immutable bytes: an owned buffer, a memory mapping or a loaded file;
+// copies share the bytes, which live until the last copy is gone
+struct source {
+    source() = default;
+    // the bytes are not owned, they must outlive the source and its cursors
+    inline source(const uint8_t* data,size_t size) : _data(data),_size(size) {}
+
+    static inline source from_buffer(buffer_t&& buf) {
+        auto keep = std::make_shared<const buffer_t>(std::move(buf));
+        source s(keep->data(),keep->size());
+        s._keep = std::move(keep);
+        return s;
+    }
+
+    // @return: empty if the file cannot be mapped
+    static inline source from_mapped(const std::string& path) {
+        auto keep = std::make_shared<const mapped_file>(path);
+        if(!keep->is_open())
+            return {};
+        source s(keep->data(),keep->size());
+        s._keep = std::move(keep);
+        return s;
+    }
+
+    // read the whole file through raw_file
+    // @return: empty if the file cannot be opened
+    static inline source from_file(const std::string& path) {
+        raw_file f(path,file_sequential);
+        if(!f.is_open())
+            return {};
+        buffer_t buf(f.size());
+        buf.resize(f.read_at(buf.data(),buf.size(),0));
+        return from_buffer(std::move(buf));
+    }
+
+    inline const uint8_t* data() const {
+        return _data;
+    }
+    inline size_t size() const {
+        return _size;
+    }
+    inline bool empty() const {
+        return _size == 0;
+    }
+
+    // [offset,offset + length) sharing the bytes, clamped to the end
+    inline source slice(size_t offset,size_t length) const {
+        if(offset > _size) offset = _size;
+        if(length > _size - offset) length = _size - offset;
+        source s(*this);
+        s._data += offset;
+        s._size = length;
+        return s;
+    }
+
+    // a cursor over the bytes, valid as long as a copy of the source lives
+    inline cursor open() const;
+private:
+    std::shared_ptr<const void> _keep;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+};
+
+// the position over borrowed bytes, behaves like basic_reader<Buffer>;
+// trivially copyable, so a decoder state is forked or saved by a copy
+struct basic_cursor {
+    basic_cursor() = default;
+    inline basic_cursor(const uint8_t* data,size_t size) : _data(data),_size(size) {}
+
+    // @return: the number of bytes have been read, <= size; if equal 0, means eob
+    inline size_t read(uint8_t* buf,size_t size) {
+        if(!buf || size < 1)
+            return 0;
+        const auto remain = _size - _cur;
+        if(remain >= size) {    // keep the size constant for inlined typed reads
+            memcpy(buf,_data + _cur,size);
+            _cur += size;
+            return size;
+        }
+        if(remain < 1)
+            return 0;
+        memcpy(buf,_data + _cur,remain);
+        _cur += remain;
+        return remain;
+    }
+
+    // zero-copy read, the bytes are not copied but referenced in the source
+    // @return: view of the next bytes, size <= size; if empty, means eob
+    inline view_t view(size_t size) {
+        const auto v = peek(size);
+        _cur += v.size;
+        return v;
+    }
+
+    // same as view, but the position will not be moved
+    inline view_t peek(size_t size) const {
+        const auto remain = _size - _cur;
+        if(remain < size)
+            size = remain;
+        return { _data + _cur,size };
+    }
+
+    // check once that n bytes remain, to read them without checks
+    // @return: a cursor over them, false if less than n bytes remain
+    inline read_cursor ensure(size_t n) {
+        if(_size - _cur < n)
+            return {};
+        return { _data + _cur,n,&_cur };
+    }
+
+    // a cursor over [offset,offset + length) of the bytes, clamped to their end, from its begin
+    inline cursor slice(size_t offset,size_t length) const;
+
+    // a slice over the next length bytes, the position is moved after it
+    inline cursor subreader(size_t length);
+
+    inline size_t pos() const {
+        return _cur;
+    }
+
+    inline size_t size() const {
+        return _size;
+    }
+
+    // pos < 0: to the end; others: to the pos
+    // @return: position after seek
+    inline size_t seek(pos_t pos) {
+        _cur = pos >= 0 && (size_t)pos < _size ? (size_t)pos : _size;
+        return _cur;
+    }
+
+    // offset from current pos
+    // @return: position after offset
+    inline size_t offset(pos_t ofs) {
+        auto cur = (pos_t)_cur + ofs;
+        if(cur < 0) _cur = 0;
+        else if((size_t)cur > _size) _cur = _size;
+        else _cur = (size_t)cur;
+        return _cur;
+    }
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    size_t _cur = 0;
+};
+
+static_assert(std::is_trivially_copyable<cursor>::value,"cursor must stay trivially copyable");
+
+inline cursor basic_cursor::slice(size_t offset,size_t length) const {
+    if(offset > _size) offset = _size;
+    if(length > _size - offset) length = _size - offset;
+    return { _data + offset,length };
+}
+
+inline cursor basic_cursor::subreader(size_t length) {
+    const auto v = view(length);
+    return { v.data,v.size };
+}
+
+inline cursor source::open() const {
+    return { _data,_size };
+}
+
+}
+
+}
+
+// BIO_FIELDS(T,field...): declare the schema of T with native coding, up to 32 fields;
+// must be used in the namespace of T
+#define BIO_FIELDS(T,...) \
+    inline auto bio_fields(const T*) { \
+        return std::make_tuple(BIO_EXPAND(BIO_CAT(BIO_FIELDS_,BIO_NARG(__VA_ARGS__))(T,__VA_ARGS__))); \
+    }
+
+#define BIO_EXPAND(x) x
+#define BIO_CAT_(a,b) a##b
+#define BIO_CAT(a,b) BIO_CAT_(a,b)
+#define BIO_NARG_(_1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16,_17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32,N,...) N
+#define BIO_NARG(...) BIO_EXPAND(BIO_NARG_(__VA_ARGS__,32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1))
+#define BIO_FIELD_(T,m) ::ck::bio::field(&T::m)
+#define BIO_FIELDS_1(T,m) BIO_FIELD_(T,m)
+#define BIO_FIELDS_2(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_1(T,__VA_ARGS__))
+#define BIO_FIELDS_3(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_2(T,__VA_ARGS__))
+#define BIO_FIELDS_4(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_3(T,__VA_ARGS__))
+#define BIO_FIELDS_5(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_4(T,__VA_ARGS__))
+#define BIO_FIELDS_6(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_5(T,__VA_ARGS__))
+#define BIO_FIELDS_7(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_6(T,__VA_ARGS__))
+#define BIO_FIELDS_8(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_7(T,__VA_ARGS__))
+#define BIO_FIELDS_9(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_8(T,__VA_ARGS__))
+#define BIO_FIELDS_10(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_9(T,__VA_ARGS__))
+#define BIO_FIELDS_11(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_10(T,__VA_ARGS__))
+#define BIO_FIELDS_12(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_11(T,__VA_ARGS__))
+#define BIO_FIELDS_13(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_12(T,__VA_ARGS__))
+#define BIO_FIELDS_14(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_13(T,__VA_ARGS__))
+#define BIO_FIELDS_15(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_14(T,__VA_ARGS__))
+#define BIO_FIELDS_16(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_15(T,__VA_ARGS__))
+#define BIO_FIELDS_17(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_16(T,__VA_ARGS__))
+#define BIO_FIELDS_18(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_17(T,__VA_ARGS__))
+#define BIO_FIELDS_19(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_18(T,__VA_ARGS__))
+#define BIO_FIELDS_20(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_19(T,__VA_ARGS__))
+#define BIO_FIELDS_21(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_20(T,__VA_ARGS__))
+#define BIO_FIELDS_22(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_21(T,__VA_ARGS__))
+#define BIO_FIELDS_23(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_22(T,__VA_ARGS__))
+#define BIO_FIELDS_24(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_23(T,__VA_ARGS__))
+#define BIO_FIELDS_25(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_24(T,__VA_ARGS__))
+#define BIO_FIELDS_26(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_25(T,__VA_ARGS__))
+#define BIO_FIELDS_27(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_26(T,__VA_ARGS__))
+#define BIO_FIELDS_28(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_27(T,__VA_ARGS__))
+#define BIO_FIELDS_29(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_28(T,__VA_ARGS__))
+#define BIO_FIELDS_30(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_29(T,__VA_ARGS__))
+#define BIO_FIELDS_31(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_30(T,__VA_ARGS__))
+#define BIO_FIELDS_32(T,m,...) BIO_FIELD_(T,m),BIO_EXPAND(BIO_FIELDS_31(T,__VA_ARGS__))
+
 #endif // CK_BIO_HPP
@@ -15,7 +15,7 @@ int main() {
 
     std::ofstream fo("H:/test4.ckt",std::ios::binary);
     auto wt = make_writer(fo);
-    wt.write("CKT");
+    wt.write("CKT",3);
     wt.write(compressed);
 
     return 0;